@@ -0,0 +1,44 @@
+#include <algorithm>
+
+#include "Baseline.h"
+#include "RawKernels.h"
+
+namespace Wacom {
+
+
+auto Baseline::update(const RawFrame& frame) -> const RawFrame& {
+    const auto count = frame.sensitivity.size();
+
+    if (_signal.width != frame.width || _signal.height != frame.height || _mean.size() != count) {
+        _mean.resize(count);
+        _variance.resize(count);
+        _signal.sensitivity.resize(count);
+        _signal.width = frame.width;
+        _signal.height = frame.height;
+        _frames = 0;
+    }
+
+    // Start from the first frame, and assume it's untouched
+    if (_frames == 0) {
+        std::copy(frame.sensitivity.begin(), frame.sensitivity.end(), _mean.begin());
+        std::fill(_variance.begin(), _variance.end(), 1.0f);
+    }
+
+    // Plain average until there's enough history for `_rate` to take over
+    const float rate = std::max(_rate, 1.0f / float(_frames + 1));
+
+    subtractBaseline(frame.sensitivity.data(), count,
+                     _mean.data(), _variance.data(),
+                     rate, _sigmas, _floor,
+                     _signal.sensitivity.data());
+
+    _signal.deviceId = frame.deviceId;
+    _signal.frameNumber = frame.frameNumber;
+    _signal.timestamp = frame.timestamp;
+    _frames++;
+
+    return _signal;
+}
+
+
+}
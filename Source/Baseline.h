@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "RawFrame.h"
+
+namespace Wacom {
+
+// Running per-cell background model of raw sensor frames
+//
+// Tracks the mean and variance of every cell while untouched, and
+// subtracts the former from each frame. Cells within `sigmas` standard
+// deviations (plus `floor`) of their mean are zeroed, such that what
+// remains is touch alone, with drift and per-cell offsets removed.
+//
+// One pass over the frame, memory is allocated when the grid size changes.
+class Baseline {
+public:
+    // Returns `frame` minus the background, valid until the next call
+    auto update(const RawFrame& frame) -> const RawFrame&;
+
+    // Start over, e.g. after the sensor was covered during startup
+    void reset() { _frames = 0; }
+
+    // How quickly the model follows drift, as a fraction per frame
+    void setRate(float rate) { _rate = rate; }
+
+    // How far above its mean a cell must be, in standard deviations
+    void setSigmas(float sigmas) { _sigmas = sigmas; }
+    auto sigmas() const -> float { return _sigmas; }
+
+    // ..plus this, such that perfectly quiet cells don't trigger on a single count
+    void setFloor(float floor) { _floor = floor; }
+
+    // Frames folded into the model so far
+    auto frameCount() const -> std::size_t { return _frames; }
+
+private:
+    float _rate { 1.0f / 64.0f };
+    float _sigmas { 4.0f };
+    float _floor { 2.0f };
+    std::size_t _frames { 0 };
+
+    std::vector<float> _mean;
+    std::vector<float> _variance;
+    RawFrame _signal;
+};
+
+}
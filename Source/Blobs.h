@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Corrade/Containers/ArrayView.h>
+#include <WacomMultiTouchTypes.h>
+
+namespace Wacom {
+
+struct Blob {
+    int blobId;
+    float x;
+    float y;
+    bool confidence;
+    WacomMTBlobType type;
+    int parentId;
+
+    // Contour, in `BlobFrame::points`
+    std::size_t first;
+    std::size_t count;
+};
+
+
+// Every blob of one `WacomMTBlobAggregate`
+//
+// Contours of all blobs are stored back-to-back in `points`, an arena
+// that is cleared rather than freed between frames. Once it has grown
+// to the largest frame seen, copying a frame in allocates nothing.
+struct BlobFrame {
+    int deviceId { 0 };
+    int frameNumber { 0 };
+    std::int64_t timestamp { 0 };  // See `Timestamp`
+
+    // Logical area of the device, for normalising coordinates
+    float originX { 0.0f };
+    float originY { 0.0f };
+    float width { 1.0f };
+    float height { 1.0f };
+
+    std::vector<Blob> blobs;
+    std::vector<WacomMTBlobPoint> points;
+
+    auto contour(const Blob& blob) const -> Corrade::Containers::ArrayView<const WacomMTBlobPoint> {
+        return { points.data() + blob.first, blob.count };
+    }
+};
+
+}
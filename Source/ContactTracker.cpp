@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "ContactTracker.h"
+#include "RawKernels.h"
+
+namespace Wacom {
+
+
+ContactTracker::ContactTracker(std::size_t maxContacts)
+    : _maxContacts(maxContacts) {
+    _tracks.reserve(maxContacts);
+    _nextTracks.reserve(maxContacts);
+    _pairs.reserve(maxContacts * maxContacts);
+}
+
+
+void ContactTracker::_resize(int width, int height) {
+    const auto count = std::size_t(width) * std::size_t(height);
+
+    _width = width;
+    _height = height;
+
+    _cells.resize(count);
+    _values.resize(count);
+    _labels.assign(count, 0);
+    _parents.resize(count + 1);
+    _componentOf.resize(count + 1);
+    _components.reserve(count);
+}
+
+
+void ContactTracker::poll(const RawFrame& frame, Contacts& contacts) {
+    contacts.reserve(_maxContacts);
+
+    // Stick keys, like `Touch::poll()`
+    for (std::size_t ii = 0; ii < contacts.size();) {
+        auto& event = *(contacts.begin() + ii);
+
+        if (event.state == TouchState::Up) {
+            contacts.erase(event.deviceId, event.fingerId);
+            continue;
+        }
+
+        if (event.state == TouchState::Down) {
+            event.state = TouchState::Hold;
+        }
+
+        ii++;
+    }
+
+    // Nothing new since last time
+    if (frame.sensitivity.empty() || frame.timestamp == _timestamp) return;
+
+    if (frame.width != _width || frame.height != _height) {
+        this->_resize(frame.width, frame.height);
+    }
+
+    // Background cells come back as 0, anything else is touch
+    if (_baselineEnabled) this->_label(_baseline.update(frame), 0);
+    else this->_label(frame, _threshold);
+
+    this->_measure();
+    this->_match();
+    this->_emit(frame, contacts);
+
+    _deviceId = frame.deviceId;
+    _frameNumber = frame.frameNumber;
+    _timestamp = frame.timestamp;
+    _frameCount++;
+}
+
+
+auto ContactTracker::_find(int label) -> int {
+    while (_parents[label] != label) {
+        _parents[label] = _parents[_parents[label]];
+        label = _parents[label];
+    }
+
+    return label;
+}
+
+
+void ContactTracker::_union(int a, int b) {
+    a = this->_find(a);
+    b = this->_find(b);
+
+    // Lowest label wins, such that roots come first in scan order
+    if (a < b) _parents[b] = a;
+    else if (b < a) _parents[a] = b;
+}
+
+
+void ContactTracker::_label(const RawFrame& frame, unsigned short threshold) {
+    _active = compactCells(frame.sensitivity.data(), frame.sensitivity.size(),
+                           threshold, _cells.data(), _values.data());
+
+    // Labels are 1-based indices into `_cells`, 0 being background.
+    // Only the previous row and cell can have been labeled already.
+    for (std::size_t index = 0; index < _active; index++) {
+        const int label = int(index) + 1;
+        const int cell = int(_cells[index]);
+        const int x = cell % _width;
+        const int y = cell / _width;
+
+        _parents[label] = label;
+        _componentOf[label] = -1;
+        _labels[cell] = label;
+
+        if (x > 0 && _labels[cell - 1]) this->_union(label, _labels[cell - 1]);
+
+        if (y > 0) {
+            const int above = cell - _width;
+            if (x > 0 && _labels[above - 1]) this->_union(label, _labels[above - 1]);
+            if (_labels[above]) this->_union(label, _labels[above]);
+            if (x + 1 < _width && _labels[above + 1]) this->_union(label, _labels[above + 1]);
+        }
+    }
+}
+
+
+void ContactTracker::_measure() {
+    _components.clear();
+
+    for (std::size_t index = 0; index < _active; index++) {
+        const int cell = int(_cells[index]);
+        const int root = this->_find(int(index) + 1);
+
+        if (_componentOf[root] < 0) {
+            _componentOf[root] = int(_components.size());
+            _components.push_back(Component{});
+            _components.back().track = -1;
+        }
+
+        auto& component = _components[_componentOf[root]];
+        const double weight = _values[index];
+        const double x = cell % _width;
+        const double y = cell / _width;
+
+        component.weight += weight;
+        component.wx += weight * x;
+        component.wy += weight * y;
+        component.wxx += weight * x * x;
+        component.wxy += weight * x * y;
+        component.wyy += weight * y * y;
+        component.cells++;
+        component.peak = std::max(component.peak, _values[index]);
+
+        // Leave the grid blank for next frame, touching only what we wrote
+        _labels[cell] = 0;
+    }
+
+    _components.erase(std::remove_if(_components.begin(), _components.end(), [this](const Component& component) {
+        return component.cells < _minCells;
+    }), _components.end());
+
+    // Keep the strongest, e.g. when a palm breaks up into many
+    if (_components.size() > _maxContacts) {
+        std::nth_element(_components.begin(), _components.begin() + _maxContacts, _components.end(),
+                         [](const Component& a, const Component& b) { return a.weight > b.weight; });
+        _components.resize(_maxContacts);
+    }
+}
+
+
+void ContactTracker::_match() {
+    _pairs.clear();
+
+    for (auto& track : _tracks) track.fingerId = -std::abs(track.fingerId);
+
+    for (int t = 0; t < int(_tracks.size()); t++) {
+        for (int c = 0; c < int(_components.size()); c++) {
+            const auto& component = _components[c];
+            const double dx = component.wx / component.weight - _tracks[t].x;
+            const double dy = component.wy / component.weight - _tracks[t].y;
+            const double distance = std::sqrt(dx * dx + dy * dy);
+
+            if (distance <= _maxDistance) _pairs.push_back({ distance, t, c });
+        }
+    }
+
+    // Greedy, closest first; at 10 or so contacts, that's all it takes
+    std::sort(_pairs.begin(), _pairs.end(), [](const Pair& a, const Pair& b) {
+        return a.distance < b.distance;
+    });
+
+    for (const auto& pair : _pairs) {
+        auto& track = _tracks[pair.track];
+        auto& component = _components[pair.component];
+
+        if (track.fingerId > 0 || component.track >= 0) continue;
+
+        // Positive once matched
+        track.fingerId = -track.fingerId;
+        component.track = pair.track;
+    }
+}
+
+
+void ContactTracker::_emit(const RawFrame& frame, Contacts& contacts) {
+    // Unmatched tracks have lifted, or moved on to another device
+    for (const auto& track : _tracks) {
+        if (track.fingerId > 0 && frame.deviceId == _deviceId) continue;
+
+        if (auto* event = contacts.find(_deviceId, std::abs(track.fingerId))) {
+            event->state = TouchState::Up;
+        }
+    }
+
+    _nextTracks.clear();
+
+    for (const auto& component : _components) {
+        const double x = component.wx / component.weight;
+        const double y = component.wy / component.weight;
+
+        // Covariance, plus that of a single uniform cell such that
+        // one-cell contacts still have a size
+        const double xx = component.wxx / component.weight - x * x + 1.0 / 12.0;
+        const double xy = component.wxy / component.weight - x * y;
+        const double yy = component.wyy / component.weight - y * y + 1.0 / 12.0;
+
+        const double mean = (xx + yy) / 2.0;
+        const double spread = std::sqrt((xx - yy) * (xx - yy) / 4.0 + xy * xy);
+        const double major = 4.0 * std::sqrt(mean + spread);
+        const double minor = 4.0 * std::sqrt(std::max(mean - spread, 0.0));
+
+        const bool matched = component.track >= 0 && frame.deviceId == _deviceId;
+
+        TouchEvent event {};
+        event.fingerId     = matched ? _tracks[component.track].fingerId : _nextId++;
+        event.fingerCount  = int(_components.size());
+        event.deviceId     = frame.deviceId;
+        event.frameNumber  = frame.frameNumber;
+        event.timestamp    = frame.timestamp;
+        event.confidence   = _maxCells <= 0 || component.cells <= _maxCells;
+        event.x            = float((x + 0.5) / _width);
+        event.y            = float((y + 0.5) / _height);
+        // Axes of the ellipse along `orientation`, so both relative to the
+        // sensor's width; cells are square, but rows and columns differ in number
+        event.width        = float(major / _width);
+        event.height       = float(minor / _width);
+        event.orientation  = float(std::atan2(2.0 * xy, xx - yy) / 2.0 * 180.0 / 3.14159265358979);
+        event.sensitivity  = component.peak;
+
+        if (auto* existing = matched ? contacts.find(event.deviceId, event.fingerId) : nullptr) {
+            event.state = existing->state;
+            *existing = event;
+        }
+        else {
+            event.state = TouchState::Down;
+            if (!contacts.insert(event)) continue;
+        }
+
+        _nextTracks.push_back({ event.fingerId, x, y });
+    }
+
+    std::swap(_tracks, _nextTracks);
+}
+
+
+auto benchmarkTracker(int width, int height, int fingers, std::size_t frames, bool baseline) -> TrackerBenchmark {
+    using Clock = std::chrono::steady_clock;
+
+    ContactTracker tracker { std::size_t(std::max(fingers, 1)) };
+    tracker.setBaselineEnabled(baseline);
+    Contacts contacts { std::size_t(std::max(fingers, 1)) };
+
+    RawFrame frame;
+    frame.width = width;
+    frame.height = height;
+    frame.sensitivity.resize(std::size_t(width) * std::size_t(height));
+
+    TrackerBenchmark result;
+    result.width = width;
+    result.height = height;
+    result.frames = frames;
+
+    std::uint32_t seed = 12345;
+    double total { 0.0 };
+
+    for (std::size_t index = 0; index < frames; index++) {
+        // Noise up to the Scribble sample's threshold, and fingers circling
+        for (auto& cell : frame.sensitivity) {
+            seed = seed * 1664525u + 1013904223u;
+            cell = (unsigned short)((seed >> 24) % 5);
+        }
+
+        for (int finger = 0; finger < fingers; finger++) {
+            const float angle = index * 0.01f + finger * 6.2831853f / fingers;
+            const float cx = width * (0.5f + 0.35f * std::cos(angle));
+            const float cy = height * (0.5f + 0.35f * std::sin(angle));
+
+            // Within 3 cells is all that's above the noise
+            for (int y = std::max(int(cy) - 3, 0); y <= std::min(int(cy) + 3, height - 1); y++) {
+                for (int x = std::max(int(cx) - 3, 0); x <= std::min(int(cx) + 3, width - 1); x++) {
+                    const float dx = x - cx;
+                    const float dy = y - cy;
+                    frame.sensitivity[std::size_t(y) * std::size_t(width) + std::size_t(x)] +=
+                        (unsigned short)(400.0f * std::exp(-(dx * dx + dy * dy) / 3.0f));
+                }
+            }
+        }
+
+        frame.frameNumber = int(index);
+        frame.timestamp = Timestamp(index + 1);
+
+        const auto start = Clock::now();
+        tracker.poll(frame, contacts);
+        const double elapsed = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+        total += elapsed;
+        result.maxFrame = std::max(result.maxFrame, elapsed);
+        result.contacts += contacts.size();
+    }
+
+    result.meanFrame = frames ? total / frames : 0.0;
+    return result;
+}
+
+
+}
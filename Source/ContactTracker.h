@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Baseline.h"
+#include "RawFrame.h"
+#include "Wacom.h"
+
+// Cells must exceed this to count as touched, as per the Scribble sample
+#define DEFAULT_RAW_THRESHOLD 4
+
+namespace Wacom {
+
+// Finds contacts in raw sensor frames, as an alternative to the SDK's own
+//
+// Above-threshold cells are grouped into 8-connected components, each
+// of which is reduced to a sensitivity-weighted centroid and ellipse.
+// Components are matched to those of the previous frame by distance,
+// such that a contact keeps its ID for as long as it's in contact.
+//
+// Results are written to `Contacts` exactly like `Touch::poll(Contacts&)`
+// would; Down once, then Hold, then Up once. Memory is allocated when the
+// grid size changes only.
+class ContactTracker {
+public:
+    explicit ContactTracker(std::size_t maxContacts = DEFAULT_FINGER_MAX);
+
+    // Process `frame` if it's new, and update `contacts` either way
+    void poll(const RawFrame& frame, Contacts& contacts);
+
+    // Subtract a running background from each frame before labeling,
+    // in place of the fixed `threshold()`
+    void setBaselineEnabled(bool enabled) { _baselineEnabled = enabled; }
+    bool baselineEnabled() const { return _baselineEnabled; }
+    auto baseline() -> Baseline& { return _baseline; }
+
+    // Sensitivity a cell must exceed to count as touched
+    void setThreshold(unsigned short threshold) { _threshold = threshold; }
+    auto threshold() const -> unsigned short { return _threshold; }
+
+    // Components smaller than this are ignored as noise
+    void setMinCells(int cells) { _minCells = cells; }
+
+    // Components larger than this are reported without `confidence`,
+    // e.g. palms, or 0 for no limit
+    void setMaxCells(int cells) { _maxCells = cells; }
+
+    // Furthest a contact may move between two frames and keep its ID, in cells
+    void setMaxDistance(float cells) { _maxDistance = cells; }
+
+    // Frames processed, and contacts found in the last one
+    auto frameCount() const -> std::size_t { return _frameCount; }
+    auto componentCount() const -> std::size_t { return _components.size(); }
+
+private:
+    struct Component {
+        double weight, wx, wy, wxx, wxy, wyy;
+        int cells;
+        unsigned short peak;
+
+        // Index into `_tracks`, or -1 if new this frame
+        int track;
+    };
+
+    struct Track {
+        FingerId fingerId;
+        double x, y;
+    };
+
+    struct Pair {
+        double distance;
+        int track;
+        int component;
+    };
+
+    void _resize(int width, int height);
+    void _label(const RawFrame& frame, unsigned short threshold);
+    void _measure();
+    void _match();
+    void _emit(const RawFrame& frame, Contacts& contacts);
+
+    auto _find(int label) -> int;
+    void _union(int a, int b);
+
+    std::size_t _maxContacts;
+    unsigned short _threshold { DEFAULT_RAW_THRESHOLD };
+    int _minCells { 1 };
+    int _maxCells { 0 };
+    float _maxDistance { 8.0f };
+
+    Baseline _baseline;
+    bool _baselineEnabled { false };
+
+    int _width { 0 };
+    int _height { 0 };
+    int _deviceId { 0 };
+    int _frameNumber { 0 };
+    Timestamp _timestamp { 0 };
+    std::size_t _frameCount { 0 };
+    FingerId _nextId { 1 };
+
+    // Per frame, sized to the grid, of which `_active` cells are in use
+    std::size_t _active { 0 };
+    std::vector<std::uint32_t> _cells;
+    std::vector<unsigned short> _values;
+    std::vector<int> _labels;
+    std::vector<int> _parents;
+    std::vector<int> _componentOf;
+    std::vector<Component> _components;
+
+    // Sized to `maxContacts`
+    std::vector<Track> _tracks;
+    std::vector<Track> _nextTracks;
+    std::vector<Pair> _pairs;
+};
+
+
+
+// Time taken by `ContactTracker::poll()` per frame
+struct TrackerBenchmark {
+    int width { 0 };
+    int height { 0 };
+    std::size_t frames { 0 };
+
+    // Summed over every frame, e.g. `frames * fingers` when all are found
+    std::size_t contacts { 0 };
+
+    // In microseconds
+    double meanFrame { 0.0 };
+    double maxFrame { 0.0 };
+};
+
+// Of `frames` synthetic `width` x `height` frames, with `fingers` touches
+// circling over noise, and optionally the running baseline
+auto benchmarkTracker(int width, int height, int fingers, std::size_t frames, bool baseline) -> TrackerBenchmark;
+
+}
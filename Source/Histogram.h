@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Wacom {
+
+// Distribution of durations, in nanoseconds, in fixed memory
+//
+// Buckets are linear up to 16 and logarithmic thereafter, 8 per power of
+// two, such that any value is off by at most 1/8th. Any number of threads
+// may `record()` concurrently with any number reading, without locks.
+class Histogram {
+public:
+    static constexpr std::size_t SubBits = 3;
+    static constexpr std::size_t SubBuckets = std::size_t(1) << SubBits;
+    static constexpr std::size_t Linear = SubBuckets * 2;
+    static constexpr std::size_t BucketCount = Linear + (64 - SubBits - 1) * SubBuckets;
+
+    // A copy, for reading without it changing underneath
+    struct Snapshot {
+        std::array<std::uint64_t, BucketCount> buckets {};
+        std::uint64_t count { 0 };
+        std::int64_t sum { 0 };
+        std::int64_t max { 0 };
+
+        // E.g. of several runs, or several histograms of the same thing
+        void merge(const Snapshot& other) {
+            for (std::size_t index = 0; index < BucketCount; index++) buckets[index] += other.buckets[index];
+            count += other.count;
+            sum += other.sum;
+            max = std::max(max, other.max);
+        }
+
+        auto mean() const -> std::int64_t { return count ? sum / std::int64_t(count) : 0; }
+
+        // Upper bound of the bucket holding the `fraction` quantile, e.g. 0.99
+        auto percentile(double fraction) const -> std::int64_t {
+            if (!count) return 0;
+
+            const auto rank = std::uint64_t(fraction * double(count - 1)) + 1;
+            std::uint64_t seen { 0 };
+
+            for (std::size_t index = 0; index < BucketCount; index++) {
+                seen += buckets[index];
+                if (seen >= rank) return std::min(Histogram::upper(index), max);
+            }
+
+            return max;
+        }
+    };
+
+    Histogram() = default;
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+
+    void record(std::int64_t value) {
+        if (value < 0) value = 0;
+
+        _buckets[Histogram::bucket(std::uint64_t(value))].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(value, std::memory_order_relaxed);
+
+        auto max = _max.load(std::memory_order_relaxed);
+        while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+    }
+
+    // Consistent per bucket, though not across buckets while being recorded into
+    auto snapshot() const -> Snapshot {
+        Snapshot snapshot;
+        for (std::size_t index = 0; index < BucketCount; index++) {
+            snapshot.buckets[index] = _buckets[index].load(std::memory_order_relaxed);
+        }
+
+        snapshot.count = _count.load(std::memory_order_relaxed);
+        snapshot.sum = _sum.load(std::memory_order_relaxed);
+        snapshot.max = _max.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    void reset() {
+        for (auto& bucket : _buckets) bucket.store(0, std::memory_order_relaxed);
+        _count.store(0, std::memory_order_relaxed);
+        _sum.store(0, std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+    }
+
+    static auto bucket(std::uint64_t value) -> std::size_t {
+        if (value < Linear) return std::size_t(value);
+
+        std::size_t top { 0 };
+        for (auto v = value; v >>= 1;) top++;
+
+        const std::size_t shift = top - SubBits;
+        return Linear + (top - SubBits - 1) * SubBuckets + std::size_t(value >> shift) - SubBuckets;
+    }
+
+    // Largest value that goes in `index`
+    static auto upper(std::size_t index) -> std::int64_t {
+        if (index < Linear) return std::int64_t(index);
+
+        const std::size_t top = (index - Linear) / SubBuckets + SubBits + 1;
+        const std::size_t sub = (index - Linear) % SubBuckets;
+        const std::size_t shift = top - SubBits;
+        const auto lower = std::uint64_t(SubBuckets + sub) << shift;
+        return std::int64_t(std::min<std::uint64_t>(lower + (std::uint64_t(1) << shift) - 1, INT64_MAX));
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, BucketCount> _buckets {};
+    std::atomic<std::uint64_t> _count { 0 };
+    std::atomic<std::int64_t> _sum { 0 };
+    std::atomic<std::int64_t> _max { 0 };
+};
+
+}
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "LoadGenerator.h"
+
+
+namespace Wacom {
+
+
+static const double Tau = 6.283185307179586;
+
+
+LoadGenerator::LoadGenerator(LoadOptions options, std::size_t queueCapacity)
+    : Touch(queueCapacity), _options(options), _random(options.seed) {
+
+    _options.fingers = std::max(_options.fingers, 1);
+    _options.rate = std::max(_options.rate, 1.0f);
+
+    _fingers.resize(std::size_t(_options.fingers));
+    _packet.resize(std::size_t(_options.fingers));
+
+    for (auto& finger : _fingers) {
+        finger.fingerId = _nextId++;
+        finger.state = WMTFingerStateNone;
+        finger.x = 0.5f;
+        finger.y = 0.5f;
+    }
+}
+
+
+LoadGenerator::~LoadGenerator() {
+    _stop.store(true, std::memory_order_relaxed);
+    if (_thread.joinable()) _thread.join();
+}
+
+
+bool LoadGenerator::init() {
+    if (_thread.joinable()) return false;
+
+    _started = now();
+    _thread = std::thread(&LoadGenerator::_run, this);
+    return true;
+}
+
+
+void LoadGenerator::wait() {
+    if (_thread.joinable()) _thread.join();
+}
+
+
+void LoadGenerator::printAttachedDevices() const {
+    const auto gesture = _options.gesture == Gesture::Circle ? "Circle"
+                       : _options.gesture == Gesture::ZigZag ? "ZigZag"
+                       : _options.gesture == Gesture::Pinch ? "Pinch"
+                       : "RandomWalk";
+
+    std::cout << "LoadGenerator: "  << gesture              << std::endl
+              << "Fingers: "        << _options.fingers     << std::endl
+              << "Rate: "           << _options.rate        << std::endl
+              << "Seed: "           << _options.seed        << std::endl
+              << "Churn: "          << _options.churn       << std::endl
+              << "ReuseIds: "       << _options.reuseIds    << std::endl;
+}
+
+
+auto LoadGenerator::report() const -> Report {
+    const Timestamp stopped = _stopped.load(std::memory_order_acquire);
+    const Timestamp elapsed = (stopped ? stopped : now()) - _started;
+    const std::size_t packets = _packets.load(std::memory_order_relaxed);
+
+    Report report;
+    report.packets = packets;
+    report.packetsPerSecond = elapsed > 0 ? packets * 1.0e9 / elapsed : 0.0;
+    report.drops = this->droppedEvents();
+    report.meanLatency = this->meanLatency();
+    report.maxLatency = this->maxLatency();
+    return report;
+}
+
+
+void LoadGenerator::_run() {
+    const auto period = Timestamp(1.0e9 / _options.rate);
+    const auto frames = std::size_t(_options.duration * _options.rate);
+
+    for (std::size_t frame = 0; frames == 0 || frame < frames; frame++) {
+        if (_stop.load(std::memory_order_relaxed)) break;
+
+        // Keep to the schedule, catching up in bursts when behind it
+        std::this_thread::sleep_until(std::chrono::steady_clock::time_point{
+            std::chrono::nanoseconds{ _started + Timestamp(frame) * period }
+        });
+
+        this->_step(frame);
+    }
+
+    _stopped.store(now(), std::memory_order_release);
+    _finished.store(true, std::memory_order_release);
+}
+
+
+void LoadGenerator::_step(std::size_t frame) {
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    const double time = frame / double(_options.rate);
+
+    for (int index = 0; index < _options.fingers; index++) {
+        auto& finger = _fingers[std::size_t(index)];
+
+        if (finger.state == WMTFingerStateNone || finger.state == WMTFingerStateUp) {
+            if (finger.state == WMTFingerStateUp) {
+                finger.fingerId = _options.reuseIds && _lastLifted >= 0 ? _lastLifted : _nextId++;
+            }
+
+            finger.state = WMTFingerStateDown;
+        }
+
+        else if (_options.churn > 0.0f && chance(_random) < _options.churn) {
+            finger.state = WMTFingerStateUp;
+            _lastLifted = finger.fingerId;
+        }
+
+        else {
+            finger.state = WMTFingerStateHold;
+        }
+
+        this->_move(index, time);
+
+        WacomMTFinger& out = _packet[std::size_t(index)];
+        out.FingerID     = finger.fingerId;
+        out.X            = finger.x;
+        out.Y            = finger.y;
+        out.Width        = 0.02f;
+        out.Height       = 0.02f;
+        out.Sensitivity  = 256;
+        out.Orientation  = 0.0f;
+        out.Confidence   = true;
+        out.TouchState   = finger.state;
+    }
+
+    WacomMTFingerCollection packet {};
+    packet.Version      = WACOM_MULTI_TOUCH_API_VERSION;
+    packet.DeviceID     = 0;
+    packet.FrameNumber  = int(frame);
+    packet.FingerCount  = _options.fingers;
+    packet.Fingers      = _packet.data();
+
+    this->_fingerCallBack(&packet);
+    _packets.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void LoadGenerator::_move(int index, double time) {
+    auto& finger = _fingers[std::size_t(index)];
+    const double share = index / double(_options.fingers);
+
+    if (_options.gesture == Gesture::Circle) {
+        const double angle = Tau * (0.5 * time + share);
+        const double radius = 0.1 + 0.3 * share;
+        finger.x = float(0.5 + radius * std::cos(angle));
+        finger.y = float(0.5 + radius * std::sin(angle));
+    }
+
+    else if (_options.gesture == Gesture::ZigZag) {
+        const double phase = 2.0 * time + share;
+        const double triangle = std::abs(2.0 * (phase - std::floor(phase + 0.5)));
+        finger.x = float(0.1 + 0.8 * (0.25 * time + share - std::floor(0.25 * time + share)));
+        finger.y = float(0.2 + 0.6 * triangle);
+    }
+
+    else if (_options.gesture == Gesture::Pinch) {
+        const double angle = Tau * share;
+        const double radius = 0.05 + 0.2 * (0.5 + 0.5 * std::sin(Tau * 0.5 * time));
+        finger.x = float(0.5 + radius * std::cos(angle));
+        finger.y = float(0.5 + radius * std::sin(angle));
+    }
+
+    else {
+        std::normal_distribution<float> step(0.0f, 0.002f);
+        finger.x = std::clamp(finger.x + step(_random), 0.0f, 1.0f);
+        finger.y = std::clamp(finger.y + step(_random), 0.0f, 1.0f);
+    }
+}
+
+
+}
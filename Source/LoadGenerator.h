@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Wacom.h"
+
+namespace Wacom {
+
+enum class Gesture {
+    Circle = 0, ZigZag, Pinch, RandomWalk
+};
+
+
+struct LoadOptions {
+    int fingers { 10 };
+
+    // Packets per second
+    float rate { 1000.0f };
+
+    Gesture gesture { Gesture::Circle };
+
+    // Same seed, same packets
+    std::uint32_t seed { 0 };
+
+    // Chance of each finger lifting, per packet. It touches
+    // down again on the next packet, for rapid Down/Up churn
+    float churn { 0.0f };
+
+    // Touch down again with the ID of the finger that lifted most
+    // recently, even if that was another finger, rather than a new one
+    //
+    // Fingers lifting on the same packet all come back as that one ID, so
+    // a packet may list one ID more than once. That is deliberate, it is
+    // the worst case for anything keyed by finger ID.
+    bool reuseIds { false };
+
+    // In seconds, or 0 to run until destroyed
+    float duration { 0.0f };
+};
+
+
+// Synthetic multi-finger input, for pushing the pipeline past what a hand can
+//
+// Like `Replay`, packets are delivered to `_fingerCallBack()` from a thread
+// of its own, starting on `init()`.
+class LoadGenerator : public Touch {
+public:
+    explicit LoadGenerator(LoadOptions options,
+                           std::size_t queueCapacity = DEFAULT_QUEUE_CAPACITY);
+    ~LoadGenerator() override;
+
+    bool init() override;
+    void printAttachedDevices() const override;
+
+    // Block until `LoadOptions::duration` is up
+    void wait();
+    bool finished() const { return _finished.load(std::memory_order_acquire); }
+
+    // Of the run so far, or of the whole run once finished
+    struct Report {
+        std::size_t packets;
+        double packetsPerSecond;
+
+        // Samples lost to a full queue
+        std::size_t drops;
+
+        // From `_fingerCallBack` to `poll()`, in nanoseconds
+        Timestamp meanLatency;
+        Timestamp maxLatency;
+    };
+
+    auto report() const -> Report;
+
+private:
+    struct Finger {
+        FingerId fingerId;
+        WacomMTFingerState state;
+        float x;
+        float y;
+    };
+
+    LoadOptions _options;
+    std::mt19937 _random;
+    std::vector<Finger> _fingers;
+    std::vector<WacomMTFinger> _packet;
+    FingerId _nextId { 0 };
+    FingerId _lastLifted { -1 };
+
+    std::thread _thread;
+    std::atomic<bool> _stop { false };
+    std::atomic<bool> _finished { false };
+    std::atomic<std::size_t> _packets { 0 };
+    Timestamp _started { 0 };
+    std::atomic<Timestamp> _stopped { 0 };
+
+    void _run();
+    void _step(std::size_t frame);
+    void _move(int index, double time);
+};
+
+}
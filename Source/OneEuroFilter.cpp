@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cmath>
+
+#include "OneEuroFilter.h"
+
+namespace Wacom {
+
+static constexpr float TwoPi = 6.28318530718f;
+
+
+OneEuroFilter::OneEuroFilter(FilterOptions options, std::size_t maxContacts)
+    : _options(options), _capacity(maxContacts) {
+    _deviceIds.resize(maxContacts);
+    _fingerIds.resize(maxContacts);
+    _timestamps.resize(maxContacts);
+    _used.resize(maxContacts);
+    _seen.resize(maxContacts);
+    _slots.resize(maxContacts);
+    _dt.resize(maxContacts);
+
+    for (int channel = 0; channel < ChannelCount; channel++) {
+        _values[channel].resize(maxContacts);
+        _derivatives[channel].resize(maxContacts);
+        _inputs[channel].resize(maxContacts);
+        _previous[channel].resize(maxContacts);
+        _previousDerivatives[channel].resize(maxContacts);
+    }
+}
+
+
+void OneEuroFilter::reset() {
+    std::fill(_used.begin(), _used.end(), 0);
+}
+
+
+auto OneEuroFilter::_slot(const TouchEvent& contact) -> int {
+    int free = -1;
+
+    for (int slot = 0; slot < int(_capacity); slot++) {
+        if (!_used[slot]) {
+            if (free < 0) free = slot;
+        }
+        else if (_deviceIds[slot] == contact.deviceId && _fingerIds[slot] == contact.fingerId) {
+            // A new touch with a reused ID starts over
+            if (contact.state == TouchState::Down && _timestamps[slot] != contact.timestamp) {
+                this->_init(slot, contact);
+            }
+
+            return slot;
+        }
+    }
+
+    if (free >= 0) this->_init(free, contact);
+    return free;
+}
+
+
+void OneEuroFilter::_init(int slot, const TouchEvent& contact) {
+    // Start from wherever the contact is now
+    const float values[ChannelCount] { contact.x, contact.y, contact.width, contact.height, contact.orientation };
+
+    _used[slot] = 1;
+    _deviceIds[slot] = contact.deviceId;
+    _fingerIds[slot] = contact.fingerId;
+    _timestamps[slot] = contact.timestamp;
+
+    for (int channel = 0; channel < ChannelCount; channel++) {
+        _values[channel][slot] = values[channel];
+        _derivatives[channel][slot] = 0.0f;
+    }
+}
+
+
+void OneEuroFilter::apply(Contacts& contacts) {
+    std::fill(_seen.begin(), _seen.end(), 0);
+    std::size_t count { 0 };
+
+    // Gather contacts with something new into contiguous lanes
+    for (auto& contact : contacts) {
+        const int slot = this->_slot(contact);
+        if (slot < 0) continue;
+
+        _seen[slot] = 1;
+
+        if (contact.timestamp > _timestamps[slot] && count < _capacity) {
+            const float inputs[ChannelCount] { contact.x, contact.y, contact.width, contact.height, contact.orientation };
+
+            _slots[count] = slot;
+            _dt[count] = (contact.timestamp - _timestamps[slot]) / 1.0e9f;
+
+            for (int channel = 0; channel < ChannelCount; channel++) {
+                _inputs[channel][count] = inputs[channel];
+                _previous[channel][count] = _values[channel][slot];
+                _previousDerivatives[channel][count] = _derivatives[channel][slot];
+            }
+
+            // The short way round, e.g. from 179 to -179 degrees
+            float turn = std::fmod(_inputs[Orientation][count] - _previous[Orientation][count] + 180.0f, 360.0f);
+            if (turn < 0.0f) turn += 360.0f;
+            _inputs[Orientation][count] = _previous[Orientation][count] + turn - 180.0f;
+
+            _timestamps[slot] = contact.timestamp;
+            count++;
+        }
+    }
+
+    this->_filter(X, _options.position, count);
+    this->_filter(Y, _options.position, count);
+    this->_filter(Width, _options.size, count);
+    this->_filter(Height, _options.size, count);
+    this->_filter(Orientation, _options.orientation, count);
+
+    for (std::size_t lane = 0; lane < count; lane++) {
+        const int slot = _slots[lane];
+
+        for (int channel = 0; channel < ChannelCount; channel++) {
+            _values[channel][slot] = _inputs[channel][lane];
+            _derivatives[channel][slot] = _previousDerivatives[channel][lane];
+        }
+    }
+
+    // Write back, and forget contacts that have lifted or gone away
+    for (auto& contact : contacts) {
+        const int slot = this->_slot(contact);
+        if (slot < 0) continue;
+
+        contact.x = _values[X][slot];
+        contact.y = _values[Y][slot];
+        contact.width = _values[Width][slot];
+        contact.height = _values[Height][slot];
+        contact.orientation = _values[Orientation][slot];
+
+        if (contact.state == TouchState::Up) _seen[slot] = 0;
+    }
+
+    for (std::size_t slot = 0; slot < _capacity; slot++) {
+        if (!_seen[slot]) _used[slot] = 0;
+    }
+}
+
+
+void OneEuroFilter::_filter(Channel channel, OneEuroParameters parameters, std::size_t count) {
+    float* values = _inputs[channel].data();
+    float* derivatives = _previousDerivatives[channel].data();
+    const float* previous = _previous[channel].data();
+    const float* dt = _dt.data();
+
+    const float derivativeCutoff = TwoPi * _options.derivativeCutoff;
+    const float minCutoff = TwoPi * parameters.minCutoff;
+    const float beta = TwoPi * parameters.beta;
+
+    // Branch-free, such that the compiler is free to vectorise across contacts
+    for (std::size_t lane = 0; lane < count; lane++) {
+        const float derivative = (values[lane] - previous[lane]) / dt[lane];
+
+        const float td = derivativeCutoff * dt[lane];
+        const float smoothedDerivative = derivatives[lane] + td / (td + 1.0f) * (derivative - derivatives[lane]);
+
+        const float t = (minCutoff + beta * std::fabs(smoothedDerivative)) * dt[lane];
+        values[lane] = previous[lane] + t / (t + 1.0f) * (values[lane] - previous[lane]);
+        derivatives[lane] = smoothedDerivative;
+    }
+}
+
+
+}
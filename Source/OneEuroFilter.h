@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Wacom.h"
+
+namespace Wacom {
+
+// Cutoff of one group of channels, see `OneEuroFilter`
+struct OneEuroParameters {
+    // Cutoff at rest, in Hz. Lower is smoother, and laggier
+    float minCutoff;
+
+    // How quickly the cutoff rises with speed. Higher is less laggy, and jitterier
+    float beta;
+};
+
+
+struct FilterOptions {
+    // Normalised, like `TouchEvent::x`
+    OneEuroParameters position { 1.0f, 20.0f };
+    OneEuroParameters size { 1.0f, 0.0f };
+
+    // In degrees
+    OneEuroParameters orientation { 1.0f, 0.0f };
+
+    // Of the speed estimate itself, in Hz
+    float derivativeCutoff { 1.0f };
+};
+
+
+// Adaptive low-pass filter of position, size and orientation of every contact
+//
+// A One-Euro filter (Casiez et al, 2012); heavy smoothing at rest, where
+// jitter is most visible, relaxing with speed, where lag is. State is
+// kept per channel in structure-of-arrays form, with every contact of a
+// poll filtered in one pass per channel, such that the cost stays flat
+// as fingers are added. Memory is allocated on construction only.
+class OneEuroFilter {
+public:
+    explicit OneEuroFilter(FilterOptions options = {},
+                           std::size_t maxContacts = DEFAULT_FINGER_MAX);
+
+    void setOptions(FilterOptions options) { _options = options; }
+    auto options() const -> const FilterOptions& { return _options; }
+
+    // Filter every contact in-place, call once per poll
+    //
+    // Contacts whose timestamp hasn't changed since the last call
+    // are given their previous output, rather than filtered again.
+    void apply(Contacts& contacts);
+
+    void reset();
+
+private:
+    enum Channel {
+        X = 0, Y, Width, Height, Orientation, ChannelCount
+    };
+
+    FilterOptions _options;
+    std::size_t _capacity;
+
+    // Per slot, one per contact
+    std::vector<int> _deviceIds;
+    std::vector<FingerId> _fingerIds;
+    std::vector<Timestamp> _timestamps;
+    std::vector<char> _used;
+    std::vector<char> _seen;
+    std::vector<float> _values[ChannelCount];
+    std::vector<float> _derivatives[ChannelCount];
+
+    // Per contact being filtered this call
+    std::vector<int> _slots;
+    std::vector<float> _dt;
+    std::vector<float> _inputs[ChannelCount];
+    std::vector<float> _previous[ChannelCount];
+    std::vector<float> _previousDerivatives[ChannelCount];
+
+    auto _slot(const TouchEvent& contact) -> int;
+    void _init(int slot, const TouchEvent& contact);
+    void _filter(Channel channel, OneEuroParameters parameters, std::size_t count);
+};
+
+}
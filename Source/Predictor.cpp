@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include "Predictor.h"
+
+namespace Wacom {
+
+
+Predictor::Predictor(PredictionOptions options, std::size_t maxContacts)
+    : _options(options), _tracks(maxContacts) {
+    for (auto& track : _tracks) track.used = false;
+}
+
+
+auto Predictor::_find(int deviceId, FingerId fingerId) const -> const Track* {
+    for (const auto& track : _tracks) {
+        if (track.used && track.deviceId == deviceId && track.fingerId == fingerId) return &track;
+    }
+
+    return nullptr;
+}
+
+
+auto Predictor::_find(int deviceId, FingerId fingerId) -> Track* {
+    return const_cast<Track*>(static_cast<const Predictor*>(this)->_find(deviceId, fingerId));
+}
+
+
+void Predictor::update(const Samples& samples) {
+    for (const auto& sample : samples) this->update(sample);
+}
+
+
+void Predictor::update(const TouchEvent& sample) {
+    Track* track = this->_find(sample.deviceId, sample.fingerId);
+
+    if (sample.state == TouchState::Up) {
+        if (track) track->used = false;
+        return;
+    }
+
+    // Start over on Down, or pick up from wherever, e.g. when the Down was dropped
+    if (!track || sample.state == TouchState::Down) {
+        if (!track) {
+            auto it = std::find_if(_tracks.begin(), _tracks.end(), [](const Track& t) { return !t.used; });
+            if (it == _tracks.end()) return;
+            track = &*it;
+        }
+
+        track->deviceId = sample.deviceId;
+        track->fingerId = sample.fingerId;
+        track->used = true;
+        track->count = 0;
+
+        for (Axis* axis : { &track->x, &track->y }) {
+            axis->velocity = 0.0f;
+            axis->p00 = _options.measurementNoise;
+            axis->p01 = 0.0f;
+            axis->p11 = 1.0f;
+        }
+
+        track->x.position = sample.x;
+        track->y.position = sample.y;
+    }
+
+    // Duplicate timestamps carry nothing new, and would divide by zero
+    if (track->count && track->times[track->count - 1] >= sample.timestamp) return;
+
+    const float dt = track->count ? (sample.timestamp - track->times[track->count - 1]) / 1.0e9f : 0.0f;
+
+    if (track->count == PREDICTOR_HISTORY) {
+        std::copy(track->times + 1, track->times + PREDICTOR_HISTORY, track->times);
+        std::copy(track->x.history + 1, track->x.history + PREDICTOR_HISTORY, track->x.history);
+        std::copy(track->y.history + 1, track->y.history + PREDICTOR_HISTORY, track->y.history);
+        track->count--;
+    }
+
+    track->times[track->count] = sample.timestamp;
+    track->x.history[track->count] = sample.x;
+    track->y.history[track->count] = sample.y;
+    track->count++;
+
+    if (track->count > 1) {
+        this->_kalman(track->x, sample.x, dt);
+        this->_kalman(track->y, sample.y, dt);
+    }
+}
+
+
+void Predictor::_kalman(Axis& axis, float measurement, float dt) const {
+    // Predict, with white-noise acceleration
+    const float q = _options.processNoise;
+    axis.position += axis.velocity * dt;
+    axis.p00 += dt * (2.0f * axis.p01 + dt * axis.p11) + q * dt * dt * dt / 3.0f;
+    axis.p01 += dt * axis.p11 + q * dt * dt / 2.0f;
+    axis.p11 += q * dt;
+
+    // Correct
+    const float s = axis.p00 + _options.measurementNoise;
+    const float k0 = axis.p00 / s;
+    const float k1 = axis.p01 / s;
+    const float innovation = measurement - axis.position;
+
+    axis.position += k0 * innovation;
+    axis.velocity += k1 * innovation;
+    axis.p11 -= k1 * axis.p01;
+    axis.p01 -= k0 * axis.p01;
+    axis.p00 -= k0 * axis.p00;
+}
+
+
+auto Predictor::_extrapolate(const Track& track, const Axis& axis, float horizon) const -> float {
+    const int n = track.count;
+    const Timestamp last = track.times[n - 1];
+    const float latest = axis.history[n - 1];
+
+    if (_options.model == PredictionModel::Kalman) {
+        return axis.position + axis.velocity * horizon - latest;
+    }
+
+    // Least squares in time relative to the latest sample, such that
+    // the intercept stays put and only the derivatives matter
+    double s0 { 0.0 }, s1 { 0.0 }, s2 { 0.0 }, s3 { 0.0 }, s4 { 0.0 };
+    double b0 { 0.0 }, b1 { 0.0 }, b2 { 0.0 };
+
+    for (int i = 0; i < n; i++) {
+        const double t = (track.times[i] - last) / 1.0e9;
+        const double v = axis.history[i] - latest;
+
+        s0 += 1.0; s1 += t; s2 += t * t; s3 += t * t * t; s4 += t * t * t * t;
+        b0 += v; b1 += v * t; b2 += v * t * t;
+    }
+
+    if (_options.model == PredictionModel::Quadratic && n >= 3) {
+        // | s0 s1 s2 |   | a |   | b0 |
+        // | s1 s2 s3 | * | b | = | b1 |
+        // | s2 s3 s4 |   | c |   | b2 |
+        const double det = s0 * (s2 * s4 - s3 * s3) - s1 * (s1 * s4 - s3 * s2) + s2 * (s1 * s3 - s2 * s2);
+
+        if (std::abs(det) > 1e-30) {
+            const double a = (b0 * (s2 * s4 - s3 * s3) - s1 * (b1 * s4 - s3 * b2) + s2 * (b1 * s3 - s2 * b2)) / det;
+            const double b = (s0 * (b1 * s4 - b2 * s3) - b0 * (s1 * s4 - s3 * s2) + s2 * (s1 * b2 - b1 * s2)) / det;
+            const double c = (s0 * (s2 * b2 - s3 * b1) - s1 * (s1 * b2 - s2 * b1) + b0 * (s1 * s3 - s2 * s2)) / det;
+            return float(a + b * horizon + c * horizon * horizon);
+        }
+    }
+
+    const double det = s0 * s2 - s1 * s1;
+    if (std::abs(det) < 1e-30) return 0.0f;
+
+    const double a = (b0 * s2 - b1 * s1) / det;
+    const double b = (s0 * b1 - s1 * b0) / det;
+    return float(a + b * horizon);
+}
+
+
+auto Predictor::predict(const TouchEvent& contact, Timestamp at) const -> TouchEvent {
+    TouchEvent predicted = contact;
+
+    if (_options.model == PredictionModel::None || !contact.confidence) return predicted;
+
+    const Track* track = this->_find(contact.deviceId, contact.fingerId);
+    if (!track || track->count < 2) return predicted;
+
+    const Timestamp last = track->times[track->count - 1];
+    const float horizon = std::clamp(at - last, Timestamp(0), _options.maxHorizon) / 1.0e9f;
+
+    float dx = this->_extrapolate(*track, track->x, horizon);
+    float dy = this->_extrapolate(*track, track->y, horizon);
+
+    // Ease in over the first few samples, where velocity is least certain
+    const float confidence = float(track->count - 1) / float(PREDICTOR_HISTORY - 1);
+    dx *= confidence;
+    dy *= confidence;
+
+    const float distance = std::sqrt(dx * dx + dy * dy);
+    if (distance > _options.maxDistance) {
+        dx *= _options.maxDistance / distance;
+        dy *= _options.maxDistance / distance;
+    }
+
+    predicted.x = track->x.history[track->count - 1] + dx;
+    predicted.y = track->y.history[track->count - 1] + dy;
+    predicted.timestamp = at;
+    return predicted;
+}
+
+
+void Predictor::predict(Contacts& contacts, Timestamp at) const {
+    for (auto& contact : contacts) contact = this->predict(contact, at);
+}
+
+
+auto evaluate(Corrade::Containers::ArrayView<const RecordedFinger> session,
+              PredictionOptions options, Timestamp horizon) -> PredictionError {
+    struct Pending {
+        Timestamp at;
+        float x, y;
+    };
+
+    struct Finger {
+        Timestamp timestamp;
+        float x, y;
+        std::vector<Pending> pending;
+    };
+
+    // Offline, so allocate as we please
+    Predictor predictor { options, 64 };
+    std::unordered_map<std::int64_t, Finger> fingers;
+    PredictionError error;
+    double sum { 0.0 }, squares { 0.0 };
+
+    for (const auto& record : session) {
+        TouchEvent sample {};
+        sample.fingerId = record.fingerId;
+        sample.deviceId = record.deviceId;
+        sample.frameNumber = record.frameNumber;
+        sample.timestamp = record.timestamp;
+        sample.confidence = record.confidence != 0;
+        sample.x = record.x;
+        sample.y = record.y;
+
+             if (record.state == WMTFingerStateDown) sample.state = TouchState::Down;
+        else if (record.state == WMTFingerStateHold) sample.state = TouchState::Hold;
+        else if (record.state == WMTFingerStateUp)   sample.state = TouchState::Up;
+        else continue;
+
+        const auto key = (std::int64_t(record.deviceId) << 32) | std::uint32_t(record.fingerId);
+        auto& finger = fingers[key];
+
+        // Score predictions that came due, against where the finger was by then
+        if (sample.state == TouchState::Hold) {
+            auto& pending = finger.pending;
+            auto due = std::partition(pending.begin(), pending.end(), [&](const Pending& p) {
+                return p.at > sample.timestamp;
+            });
+
+            for (auto it = due; it != pending.end(); it++) {
+                const double span = double(sample.timestamp - finger.timestamp);
+                const double t = span > 0.0 ? (it->at - finger.timestamp) / span : 1.0;
+                const double x = finger.x + (sample.x - finger.x) * t;
+                const double y = finger.y + (sample.y - finger.y) * t;
+                const double distance = std::sqrt((it->x - x) * (it->x - x) + (it->y - y) * (it->y - y));
+
+                error.count++;
+                sum += distance;
+                squares += distance * distance;
+                error.max = std::max(error.max, distance);
+            }
+
+            pending.erase(due, pending.end());
+        }
+        else {
+            // Nothing to compare against past a lift
+            finger.pending.clear();
+        }
+
+        predictor.update(sample);
+
+        if (sample.state != TouchState::Up) {
+            const auto predicted = predictor.predict(sample, sample.timestamp + horizon);
+            finger.pending.push_back({ sample.timestamp + horizon, predicted.x, predicted.y });
+        }
+
+        finger.timestamp = sample.timestamp;
+        finger.x = sample.x;
+        finger.y = sample.y;
+    }
+
+    if (error.count) {
+        error.mean = sum / error.count;
+        error.rms = std::sqrt(squares / error.count);
+    }
+
+    return error;
+}
+
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <Corrade/Containers/ArrayView.h>
+
+#include "Session.h"
+#include "Wacom.h"
+
+#define PREDICTOR_HISTORY 4
+
+namespace Wacom {
+
+enum class PredictionModel {
+    None = 0,
+
+    // Least-squares velocity over recent samples
+    Linear,
+
+    // Least-squares velocity and acceleration over recent samples
+    Quadratic,
+
+    // Constant-velocity Kalman filter, smoothest on noisy input
+    Kalman
+};
+
+
+struct PredictionOptions {
+    PredictionModel model { PredictionModel::Linear };
+
+    // Never extrapolate further ahead than this, in nanoseconds
+    Timestamp maxHorizon { 50'000'000 };
+
+    // Nor further away from the last sample than this, normalised like `x`
+    float maxDistance { 0.05f };
+
+    // Kalman tuning, in normalised units per second squared and normalised units
+    float processNoise { 50.0f };
+    float measurementNoise { 0.001f };
+};
+
+
+// Error of predictions against where a finger actually went, normalised like `x`
+struct PredictionError {
+    std::size_t count { 0 };
+    double mean { 0.0 };
+    double rms { 0.0 };
+    double max { 0.0 };
+};
+
+
+// Extrapolate each contact to when it's actually going to be seen
+//
+// Feed it every sample, e.g. `Touch::samples()`, then ask where each
+// contact is going to be at display time. Predictions are scaled back
+// by confidence, which grows with the number of samples seen so far,
+// such that a fresh contact doesn't overshoot.
+class Predictor {
+public:
+    explicit Predictor(PredictionOptions options = {},
+                       std::size_t maxContacts = DEFAULT_FINGER_MAX);
+
+    void setOptions(PredictionOptions options) { _options = options; }
+    auto options() const -> const PredictionOptions& { return _options; }
+
+    void update(const TouchEvent& sample);
+    void update(const Samples& samples);
+
+    // `contact` as of `at`, or as-is when there's nothing to go by
+    auto predict(const TouchEvent& contact, Timestamp at) const -> TouchEvent;
+
+    // Every contact in-place
+    void predict(Contacts& contacts, Timestamp at) const;
+
+private:
+    struct Axis {
+        // Oldest first, relative to nothing in particular
+        float history[PREDICTOR_HISTORY];
+
+        // Kalman state and covariance
+        float position, velocity;
+        float p00, p01, p11;
+    };
+
+    struct Track {
+        int deviceId;
+        FingerId fingerId;
+        bool used;
+
+        Timestamp times[PREDICTOR_HISTORY];
+        int count;
+
+        Axis x, y;
+    };
+
+    PredictionOptions _options;
+    std::vector<Track> _tracks;
+
+    auto _find(int deviceId, FingerId fingerId) -> Track*;
+    auto _find(int deviceId, FingerId fingerId) const -> const Track*;
+    void _kalman(Axis& axis, float measurement, float dt) const;
+    auto _extrapolate(const Track& track, const Axis& axis, float horizon) const -> float;
+};
+
+
+// Replay `session` through a `Predictor`, predicting each sample `horizon`
+// ahead and comparing against where the finger was by then
+auto evaluate(Corrade::Containers::ArrayView<const RecordedFinger> session,
+              PredictionOptions options, Timestamp horizon) -> PredictionError;
+
+}
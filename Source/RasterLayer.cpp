@@ -0,0 +1,238 @@
+#include "RasterLayer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <Corrade/Containers/Array.h>
+#include <Magnum/PixelFormat.h>
+
+// Sub-scanlines per row of a fill
+#define RASTER_FILL_SAMPLES 4
+
+using namespace Magnum;
+
+namespace Wacom {
+
+
+RasterLayer::RasterLayer()
+    : _image { PixelFormat::RGBA8Unorm, {}, Containers::Array<char>{} } {}
+
+
+void RasterLayer::resize(const Vector2i& size, float scale) {
+    if (size == _image.size() && scale == _scale) return;
+
+    const std::size_t bytes = std::size_t(std::max(size.x(), 0)) * std::size_t(std::max(size.y(), 0)) * 4;
+    _image = Image2D{ PixelFormat::RGBA8Unorm, size, Containers::Array<char>{ Containers::ValueInit, bytes } };
+    _scale = scale;
+    _count = 0;
+    _dirty = { {}, size };
+}
+
+
+void RasterLayer::clear() {
+    std::memset(_image.data().data(), 0, _image.data().size());
+    _count = 0;
+    _dirty = { {}, _image.size() };
+}
+
+
+bool RasterLayer::rasterize(const Strokes& strokes, std::size_t count) {
+    count = std::min(count, strokes.size());
+
+    // Strokes were cleared, and possibly drawn anew since
+    if (count < _count) this->clear();
+    if (count == _count || _image.size().product() == 0) return false;
+
+    for (; _count < count; _count++) {
+        const auto points = strokes.points(_count);
+        if (points.empty()) continue;
+
+        if (strokes.fill(_count)) this->_coverFill(points);
+        else                      this->_cover(points, strokes.widths(_count));
+
+        this->_composite(strokes.color(_count));
+    }
+
+    return true;
+}
+
+
+void RasterLayer::_cover(Containers::ArrayView<const ImVec2> points, Containers::ArrayView<const float> widths) {
+    // Like ImGui, never thinner than a pixel
+    const auto halfOf = [this, widths](std::size_t index) {
+        return std::max(widths[index] * _scale, 1.0f) * 0.5f;
+    };
+
+    Vector2 lower { points[0].x, points[0].y };
+    Vector2 upper { lower };
+    float half { 0.0f };
+    for (std::size_t index = 0; index < points.size(); index++) {
+        lower = Math::min(lower, Vector2{ points[index].x, points[index].y });
+        upper = Math::max(upper, Vector2{ points[index].x, points[index].y });
+        half = std::max(half, halfOf(index));
+    }
+
+    _bounds = Math::intersect(Range2Di{ Vector2i{ Math::floor(lower * _scale - Vector2{ half + 1.0f }) },
+                                        Vector2i{ Math::ceil(upper * _scale + Vector2{ half + 1.0f }) } },
+                              Range2Di{ {}, _image.size() });
+    _coverage.assign(std::size_t(_bounds.size().product()), 0);
+    if (_coverage.empty()) return;
+
+    const auto stride = _bounds.size().x();
+
+    // Each segment a capsule tapering from one width to the next,
+    // its distance field sampled at pixel centres
+    const std::size_t segments = points.size() > 1 ? points.size() - 1 : 1;
+    for (std::size_t index = 0; index < segments; index++) {
+        const auto next = std::min(index + 1, points.size() - 1);
+        const Vector2 a = Vector2{ points[index].x, points[index].y } * _scale;
+        const Vector2 b = Vector2{ points[next].x, points[next].y } * _scale;
+        const float halfA = halfOf(index);
+        const float halfB = halfOf(next);
+        const float widest = std::max(halfA, halfB);
+
+        const auto ab = b - a;
+        const auto length = ab.dot();
+
+        const Range2Di box = Math::intersect(
+            Range2Di{ Vector2i{ Math::floor(Math::min(a, b) - Vector2{ widest + 1.0f }) },
+                      Vector2i{ Math::ceil(Math::max(a, b) + Vector2{ widest + 1.0f }) } },
+            _bounds);
+
+        for (Int y = box.min().y(); y < box.max().y(); y++) {
+            auto* row = _coverage.data() + std::size_t(y - _bounds.min().y()) * stride;
+
+            for (Int x = box.min().x(); x < box.max().x(); x++) {
+                const Vector2 p { x + 0.5f, y + 0.5f };
+                const auto ap = p - a;
+                const float t = length > 0.0f ? Math::clamp(Math::dot(ap, ab) / length, 0.0f, 1.0f) : 0.0f;
+                const float distance = (ap - ab * t).length();
+
+                const float coverage = Math::clamp(halfA + (halfB - halfA) * t + 0.5f - distance, 0.0f, 1.0f);
+                auto& cell = row[x - _bounds.min().x()];
+                cell = std::max(cell, std::uint8_t(coverage * 255.0f + 0.5f));
+            }
+        }
+    }
+}
+
+
+void RasterLayer::_coverFill(Containers::ArrayView<const ImVec2> points) {
+    Vector2 lower { points[0].x, points[0].y };
+    Vector2 upper { lower };
+    for (const auto& point : points) {
+        lower = Math::min(lower, Vector2{ point.x, point.y });
+        upper = Math::max(upper, Vector2{ point.x, point.y });
+    }
+
+    _bounds = Math::intersect(Range2Di{ Vector2i{ Math::floor(lower * _scale) },
+                                        Vector2i{ Math::ceil(upper * _scale) } + Vector2i{ 1 } },
+                              Range2Di{ {}, _image.size() });
+    _coverage.assign(std::size_t(_bounds.size().product()), 0);
+    if (_coverage.empty() || points.size() < 3) return;
+
+    const auto stride = _bounds.size().x();
+    _row.resize(std::size_t(stride));
+    _spans.reserve(points.size());
+
+    // The fan ImGui's AddConvexPolyFilled() draws, triangles from point 0,
+    // such that a fill rasterised looks as it did when drawn live
+    const Vector2 origin { points[0].x * _scale, points[0].y * _scale };
+
+    for (Int y = _bounds.min().y(); y < _bounds.max().y(); y++) {
+        std::fill(_row.begin(), _row.end(), 0.0f);
+
+        for (int sample = 0; sample < RASTER_FILL_SAMPLES; sample++) {
+            const float scanline = y + (sample + 0.5f) / RASTER_FILL_SAMPLES;
+
+            // Where each triangle meets the scanline, if at all
+            _spans.clear();
+            for (std::size_t index = 1; index + 1 < points.size(); index++) {
+                const Vector2 corners[] {
+                    origin,
+                    Vector2{ points[index].x, points[index].y } * _scale,
+                    Vector2{ points[index + 1].x, points[index + 1].y } * _scale,
+                };
+
+                Span span { std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest() };
+                for (int edge = 0; edge < 3; edge++) {
+                    const auto& from = corners[edge];
+                    const auto& to = corners[(edge + 1) % 3];
+                    if ((from.y() <= scanline) == (to.y() <= scanline)) continue;
+
+                    const float x = from.x() + (to.x() - from.x()) * (scanline - from.y()) / (to.y() - from.y());
+                    span.left = Math::min(span.left, x);
+                    span.right = Math::max(span.right, x);
+                }
+
+                if (span.left < span.right) _spans.push_back(span);
+            }
+
+            std::sort(_spans.begin(), _spans.end(),
+                      [](const Span& a, const Span& b) { return a.left < b.left; });
+
+            // Of overlapping triangles, with partial pixels at either end
+            for (std::size_t index = 0; index < _spans.size();) {
+                const float left = Math::max(_spans[index].left - _bounds.min().x(), 0.0f);
+                float right = _spans[index].right;
+
+                for (index++; index < _spans.size() && _spans[index].left <= right; index++) {
+                    right = Math::max(right, _spans[index].right);
+                }
+
+                right = Math::min(right - _bounds.min().x(), float(stride));
+
+                for (Int x = Int(left); x < stride && float(x) < right; x++) {
+                    _row[std::size_t(x)] += Math::min(right, x + 1.0f) - Math::max(left, float(x));
+                }
+            }
+        }
+
+        auto* row = _coverage.data() + std::size_t(y - _bounds.min().y()) * stride;
+        for (Int x = 0; x < stride; x++) {
+            const float coverage = Math::min(_row[std::size_t(x)] / RASTER_FILL_SAMPLES, 1.0f);
+            row[x] = std::uint8_t(coverage * 255.0f + 0.5f);
+        }
+    }
+}
+
+
+void RasterLayer::_composite(ImU32 color) {
+    if (_coverage.empty()) return;
+
+    const float red = float((color >> IM_COL32_R_SHIFT) & 0xFF);
+    const float green = float((color >> IM_COL32_G_SHIFT) & 0xFF);
+    const float blue = float((color >> IM_COL32_B_SHIFT) & 0xFF);
+    const float alpha = float((color >> IM_COL32_A_SHIFT) & 0xFF) / 255.0f;
+
+    auto* pixels = reinterpret_cast<std::uint8_t*>(_image.data().data());
+    const auto width = _image.size().x();
+    const auto stride = _bounds.size().x();
+
+    for (Int y = _bounds.min().y(); y < _bounds.max().y(); y++) {
+        const auto* coverage = _coverage.data() + std::size_t(y - _bounds.min().y()) * stride;
+        auto* pixel = pixels + (std::size_t(y) * width + _bounds.min().x()) * 4;
+
+        for (Int x = 0; x < stride; x++, pixel += 4) {
+            if (!coverage[x]) continue;
+
+            // Over, with straight alpha on both sides
+            const float source = alpha * coverage[x] / 255.0f;
+            const float destination = pixel[3] / 255.0f * (1.0f - source);
+            const float result = source + destination;
+            if (result <= 0.0f) continue;
+
+            pixel[0] = std::uint8_t((red * source + pixel[0] * destination) / result + 0.5f);
+            pixel[1] = std::uint8_t((green * source + pixel[1] * destination) / result + 0.5f);
+            pixel[2] = std::uint8_t((blue * source + pixel[2] * destination) / result + 0.5f);
+            pixel[3] = std::uint8_t(result * 255.0f + 0.5f);
+        }
+    }
+
+    _dirty = Math::join(_dirty, _bounds);
+}
+
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Image.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Range.h>
+#include <imgui.h>
+
+#include "Strokes.h"
+
+// How long the canvas keeps its size before the raster follows, in milliseconds
+#define RASTER_RESIZE_DELAY 250
+
+namespace Wacom {
+
+// Finished strokes, drawn once into an image
+//
+// Drawn in software, with nothing but the CPU, and uploaded by whoever
+// displays it. Each stroke is drawn as coverage first and blended once,
+// such that overlapping segments of one stroke do not darken its edges.
+//
+// Pixels are RGBA8 with straight alpha, rows top-down like ImGui rather
+// than bottom-up like the rest of Magnum.
+//
+class RasterLayer {
+public:
+    RasterLayer();
+
+    // In pixels, with `scale` pixels per unit of a stroke
+    //
+    // Clears the image on change, every stroke is drawn anew at the
+    // next `rasterize()`. Costly, so wait for e.g. a window to stop
+    // resizing first, see `RASTER_RESIZE_DELAY`.
+    //
+    void resize(const Magnum::Vector2i& size, float scale);
+
+    // Draw strokes up until `count` not yet drawn, returns whether any were
+    bool rasterize(const Strokes& strokes, std::size_t count);
+
+    void clear();
+
+    auto image() const -> const Magnum::Image2D& { return _image; }
+    auto size() const -> Magnum::Vector2i { return _image.size(); }
+    auto scale() const -> float { return _scale; }
+
+    // Strokes drawn so far
+    auto strokeCount() const -> std::size_t { return _count; }
+
+    // Pixels changed since the last `clean()`, e.g. to upload only those
+    auto dirty() const -> Magnum::Range2Di { return _dirty; }
+    void clean() { _dirty = {}; }
+
+private:
+    void _cover(Corrade::Containers::ArrayView<const ImVec2> points,
+                Corrade::Containers::ArrayView<const float> widths);
+    void _coverFill(Corrade::Containers::ArrayView<const ImVec2> points);
+    void _composite(ImU32 color);
+
+    Magnum::Image2D _image;
+    float _scale { 1.0f };
+    std::size_t _count { 0 };
+    Magnum::Range2Di _dirty;
+
+    // Of the stroke being drawn, within its bounds
+    std::vector<std::uint8_t> _coverage;
+    std::vector<float> _row;
+
+    // Of a fill, where its triangles meet one scanline
+    struct Span { float left, right; };
+    std::vector<Span> _spans;
+    Magnum::Range2Di _bounds;
+};
+
+}
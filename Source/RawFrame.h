@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Wacom {
+
+// Sensitivity of every cell of the sensor, from one `WacomMTRawData`
+struct RawFrame {
+    int deviceId { 0 };
+    int frameNumber { 0 };
+    std::int64_t timestamp { 0 };  // See `Timestamp`
+
+    // In cells, `ScanSizeX` and `ScanSizeY` of the device
+    int width { 0 };
+    int height { 0 };
+
+    // Row-major, `width * height` cells
+    std::vector<unsigned short> sensitivity;
+
+    auto at(int x, int y) const -> unsigned short { return sensitivity[std::size_t(y) * width + x]; }
+};
+
+}
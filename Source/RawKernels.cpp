@@ -0,0 +1,658 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "RawKernels.h"
+
+#if defined(__AVX2__)
+#define WACOM_KERNELS_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WACOM_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+namespace Wacom {
+
+
+static inline int lowestBit(std::uint32_t bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return int(index);
+#else
+    return __builtin_ctz(bits);
+#endif
+}
+
+
+// Turn running sums, relative to some origin, into a centroid and covariance
+static auto finish(double w, double wx, double wy, double wxx, double wxy, double wyy,
+                   double originX, double originY) -> Moments {
+    Moments moments;
+    if (w <= 0.0) return moments;
+
+    const double x = wx / w;
+    const double y = wy / w;
+
+    moments.weight = w;
+    moments.x = originX + x;
+    moments.y = originY + y;
+    moments.xx = wxx / w - x * x;
+    moments.xy = wxy / w - x * y;
+    moments.yy = wyy / w - y * y;
+    return moments;
+}
+
+
+auto kernelPath() -> const char* {
+#if defined(WACOM_KERNELS_AVX2)
+    return "AVX2";
+#elif defined(WACOM_KERNELS_SSE2)
+    return "SSE2";
+#else
+    return "Scalar";
+#endif
+}
+
+
+static void thresholdMaskOf(const unsigned short* cells, std::size_t count,
+                            unsigned short threshold, std::uint8_t* mask, bool vectorised) {
+    std::size_t index = 0;
+
+    if (vectorised) {
+#if defined(WACOM_KERNELS_AVX2)
+        // Saturating subtract is non-zero exactly where value > threshold
+        const __m256i limit = _mm256_set1_epi16(short(threshold));
+        const __m256i zero = _mm256_setzero_si256();
+
+        for (; index + 16 <= count; index += 16) {
+            const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells + index));
+            const __m256i below = _mm256_cmpeq_epi16(_mm256_subs_epu16(value, limit), zero);
+            const __m256i packed = _mm256_packs_epi16(below, below);
+
+            // Packing works per 128-bit lane, gather both halves
+            const __m256i ordered = _mm256_permute4x64_epi64(packed, 0x08);
+            const __m128i bytes = _mm_xor_si128(_mm256_castsi256_si128(ordered), _mm_set1_epi8(-1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(mask + index), bytes);
+        }
+#elif defined(WACOM_KERNELS_SSE2)
+        const __m128i limit = _mm_set1_epi16(short(threshold));
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; index + 8 <= count; index += 8) {
+            const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + index));
+            const __m128i below = _mm_cmpeq_epi16(_mm_subs_epu16(value, limit), zero);
+            const __m128i bytes = _mm_xor_si128(_mm_packs_epi16(below, below), _mm_set1_epi8(-1));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(mask + index), bytes);
+        }
+#endif
+    }
+
+    for (; index < count; index++) {
+        mask[index] = cells[index] > threshold ? 0xFF : 0x00;
+    }
+}
+
+
+static auto compactCellsOf(const unsigned short* cells, std::size_t count, unsigned short threshold,
+                           std::uint32_t* indices, unsigned short* values, bool vectorised) -> std::size_t {
+    std::size_t found = 0;
+    std::size_t index = 0;
+
+    if (vectorised) {
+#if defined(WACOM_KERNELS_AVX2)
+        const __m256i limit = _mm256_set1_epi16(short(threshold));
+        const __m256i zero = _mm256_setzero_si256();
+
+        for (; index + 16 <= count; index += 16) {
+            const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells + index));
+            const __m256i below = _mm256_cmpeq_epi16(_mm256_subs_epu16(value, limit), zero);
+
+            // Two bits per cell
+            std::uint32_t bits = ~std::uint32_t(_mm256_movemask_epi8(below));
+
+            while (bits) {
+                const int cell = lowestBit(bits) / 2;
+                indices[found] = std::uint32_t(index + cell);
+                values[found] = cells[index + cell];
+                found++;
+                bits &= ~(3u << (cell * 2));
+            }
+        }
+#elif defined(WACOM_KERNELS_SSE2)
+        const __m128i limit = _mm_set1_epi16(short(threshold));
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; index + 8 <= count; index += 8) {
+            const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + index));
+            const __m128i below = _mm_cmpeq_epi16(_mm_subs_epu16(value, limit), zero);
+
+            std::uint32_t bits = ~std::uint32_t(_mm_movemask_epi8(below)) & 0xFFFFu;
+
+            while (bits) {
+                const int cell = lowestBit(bits) / 2;
+                indices[found] = std::uint32_t(index + cell);
+                values[found] = cells[index + cell];
+                found++;
+                bits &= ~(3u << (cell * 2));
+            }
+        }
+#endif
+    }
+
+    for (; index < count; index++) {
+        if (cells[index] > threshold) {
+            indices[found] = std::uint32_t(index);
+            values[found] = cells[index];
+            found++;
+        }
+    }
+
+    return found;
+}
+
+
+static void subtractBaselineOf(const unsigned short* cells, std::size_t count,
+                               float* mean, float* variance,
+                               float rate, float sigmas, float floor,
+                               unsigned short* signal, bool vectorised) {
+    std::size_t index = 0;
+
+    if (vectorised) {
+#if defined(WACOM_KERNELS_AVX2)
+        const __m256 r = _mm256_set1_ps(rate);
+        const __m256 k = _mm256_set1_ps(sigmas);
+        const __m256 f = _mm256_set1_ps(floor);
+        const __m256 top = _mm256_set1_ps(65535.0f);
+
+        for (; index + 8 <= count; index += 8) {
+            const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + index));
+            const __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(value));
+            const __m256 m = _mm256_loadu_ps(mean + index);
+            const __m256 s = _mm256_loadu_ps(variance + index);
+
+            const __m256 d = _mm256_sub_ps(v, m);
+            const __m256 limit = _mm256_add_ps(_mm256_mul_ps(k, _mm256_sqrt_ps(s)), f);
+            const __m256 touched = _mm256_cmp_ps(d, limit, _CMP_GT_OQ);
+
+            // Background only, touched cells keep their model as-is
+            const __m256 dm = _mm256_andnot_ps(touched, _mm256_mul_ps(r, d));
+            const __m256 ds = _mm256_andnot_ps(touched, _mm256_mul_ps(r, _mm256_sub_ps(_mm256_mul_ps(d, d), s)));
+            _mm256_storeu_ps(mean + index, _mm256_add_ps(m, dm));
+            _mm256_storeu_ps(variance + index, _mm256_add_ps(s, ds));
+
+            const __m256i kept = _mm256_cvttps_epi32(_mm256_and_ps(touched, _mm256_min_ps(d, top)));
+            const __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(kept), _mm256_extracti128_si256(kept, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(signal + index), packed);
+        }
+#elif defined(WACOM_KERNELS_SSE2)
+        const __m128 r = _mm_set1_ps(rate);
+        const __m128 k = _mm_set1_ps(sigmas);
+        const __m128 f = _mm_set1_ps(floor);
+        const __m128 top = _mm_set1_ps(65535.0f);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi32(32768);
+
+        for (; index + 4 <= count; index += 4) {
+            const __m128i value = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(cells + index));
+            const __m128 v = _mm_cvtepi32_ps(_mm_unpacklo_epi16(value, zero));
+            const __m128 m = _mm_loadu_ps(mean + index);
+            const __m128 s = _mm_loadu_ps(variance + index);
+
+            const __m128 d = _mm_sub_ps(v, m);
+            const __m128 limit = _mm_add_ps(_mm_mul_ps(k, _mm_sqrt_ps(s)), f);
+            const __m128 touched = _mm_cmpgt_ps(d, limit);
+
+            const __m128 dm = _mm_andnot_ps(touched, _mm_mul_ps(r, d));
+            const __m128 ds = _mm_andnot_ps(touched, _mm_mul_ps(r, _mm_sub_ps(_mm_mul_ps(d, d), s)));
+            _mm_storeu_ps(mean + index, _mm_add_ps(m, dm));
+            _mm_storeu_ps(variance + index, _mm_add_ps(s, ds));
+
+            // No unsigned pack before SSE4.1, so shift into signed range and back
+            const __m128i kept = _mm_cvttps_epi32(_mm_and_ps(touched, _mm_min_ps(d, top)));
+            const __m128i packed = _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(kept, bias), zero),
+                                                 _mm_set1_epi16(short(0x8000)));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(signal + index), packed);
+        }
+#endif
+    }
+
+    for (; index < count; index++) {
+        const float d = float(cells[index]) - mean[index];
+        const float limit = sigmas * std::sqrt(variance[index]) + floor;
+
+        if (d > limit) {
+            signal[index] = (unsigned short)std::min(d, 65535.0f);
+        }
+        else {
+            mean[index] += rate * d;
+            variance[index] += rate * (d * d - variance[index]);
+            signal[index] = 0;
+        }
+    }
+}
+
+
+static auto gridMomentsOf(const unsigned short* cells, int stride,
+                          int x0, int y0, int x1, int y1,
+                          unsigned short threshold, bool vectorised) -> Moments {
+    double w { 0.0 }, wx { 0.0 }, wy { 0.0 }, wxx { 0.0 }, wxy { 0.0 }, wyy { 0.0 };
+
+    for (int y = y0; y < y1; y++) {
+        const unsigned short* row = cells + std::size_t(y) * std::size_t(stride);
+
+        // Per row in float, relative to x0, so as not to lose precision
+        float rw { 0.0f }, rwx { 0.0f }, rwxx { 0.0f };
+        int x = x0;
+
+        if (vectorised) {
+#if defined(WACOM_KERNELS_AVX2)
+            const __m128i limit = _mm_set1_epi16(short(threshold));
+            const __m128i zero = _mm_setzero_si128();
+            __m256 sw = _mm256_setzero_ps(), swx = _mm256_setzero_ps(), swxx = _mm256_setzero_ps();
+            __m256 column = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+            const __m256 step = _mm256_set1_ps(8.0f);
+
+            for (; x + 8 <= x1; x += 8) {
+                const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+                const __m128i below = _mm_cmpeq_epi16(_mm_subs_epu16(value, limit), zero);
+                const __m128i kept = _mm_andnot_si128(below, value);
+                const __m256 weight = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(kept));
+                const __m256 weighted = _mm256_mul_ps(weight, column);
+
+                sw = _mm256_add_ps(sw, weight);
+                swx = _mm256_add_ps(swx, weighted);
+                swxx = _mm256_add_ps(swxx, _mm256_mul_ps(weighted, column));
+                column = _mm256_add_ps(column, step);
+            }
+
+            alignas(32) float lanes[3][8];
+            _mm256_store_ps(lanes[0], sw);
+            _mm256_store_ps(lanes[1], swx);
+            _mm256_store_ps(lanes[2], swxx);
+            for (int lane = 0; lane < 8; lane++) {
+                rw += lanes[0][lane];
+                rwx += lanes[1][lane];
+                rwxx += lanes[2][lane];
+            }
+#elif defined(WACOM_KERNELS_SSE2)
+            const __m128i limit = _mm_set1_epi16(short(threshold));
+            const __m128i zero = _mm_setzero_si128();
+            __m128 sw = _mm_setzero_ps(), swx = _mm_setzero_ps(), swxx = _mm_setzero_ps();
+            __m128 columnLow = _mm_setr_ps(0, 1, 2, 3);
+            __m128 columnHigh = _mm_setr_ps(4, 5, 6, 7);
+            const __m128 step = _mm_set1_ps(8.0f);
+
+            for (; x + 8 <= x1; x += 8) {
+                const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+                const __m128i below = _mm_cmpeq_epi16(_mm_subs_epu16(value, limit), zero);
+                const __m128i kept = _mm_andnot_si128(below, value);
+                const __m128 low = _mm_cvtepi32_ps(_mm_unpacklo_epi16(kept, zero));
+                const __m128 high = _mm_cvtepi32_ps(_mm_unpackhi_epi16(kept, zero));
+                const __m128 weightedLow = _mm_mul_ps(low, columnLow);
+                const __m128 weightedHigh = _mm_mul_ps(high, columnHigh);
+
+                sw = _mm_add_ps(sw, _mm_add_ps(low, high));
+                swx = _mm_add_ps(swx, _mm_add_ps(weightedLow, weightedHigh));
+                swxx = _mm_add_ps(swxx, _mm_add_ps(_mm_mul_ps(weightedLow, columnLow),
+                                                   _mm_mul_ps(weightedHigh, columnHigh)));
+                columnLow = _mm_add_ps(columnLow, step);
+                columnHigh = _mm_add_ps(columnHigh, step);
+            }
+
+            alignas(16) float lanes[3][4];
+            _mm_store_ps(lanes[0], sw);
+            _mm_store_ps(lanes[1], swx);
+            _mm_store_ps(lanes[2], swxx);
+            for (int lane = 0; lane < 4; lane++) {
+                rw += lanes[0][lane];
+                rwx += lanes[1][lane];
+                rwxx += lanes[2][lane];
+            }
+#endif
+        }
+
+        for (; x < x1; x++) {
+            const unsigned short value = row[x];
+            if (value <= threshold) continue;
+
+            const float column = float(x - x0);
+            rw += value;
+            rwx += value * column;
+            rwxx += value * column * column;
+        }
+
+        const double dy = double(y - y0);
+        w += rw;
+        wx += rwx;
+        wy += rw * dy;
+        wxx += rwxx;
+        wxy += rwx * dy;
+        wyy += rw * dy * dy;
+    }
+
+    return finish(w, wx, wy, wxx, wxy, wyy, double(x0), double(y0));
+}
+
+
+static auto pointMomentsOf(const WacomMTBlobPoint* points, std::size_t count, bool vectorised) -> Moments {
+    if (!count) return {};
+
+    // Relative to the first point, screen coordinates squared are big
+    const float originX = points[0].X;
+    const float originY = points[0].Y;
+
+    double w { 0.0 }, wx { 0.0 }, wy { 0.0 }, wxx { 0.0 }, wxy { 0.0 }, wyy { 0.0 };
+    std::size_t index = 0;
+
+    if (vectorised) {
+#if defined(WACOM_KERNELS_AVX2) || defined(WACOM_KERNELS_SSE2)
+        // Points are interleaved, so transpose 4 at a time
+        const __m128 ox = _mm_set1_ps(originX);
+        const __m128 oy = _mm_set1_ps(originY);
+        __m128 sw = _mm_setzero_ps(), swx = _mm_setzero_ps(), swy = _mm_setzero_ps();
+        __m128 swxx = _mm_setzero_ps(), swxy = _mm_setzero_ps(), swyy = _mm_setzero_ps();
+
+        for (; index + 4 <= count; index += 4) {
+            const WacomMTBlobPoint* p = points + index;
+            const __m128 weight = _mm_setr_ps(p[0].Sensitivity, p[1].Sensitivity, p[2].Sensitivity, p[3].Sensitivity);
+            const __m128 x = _mm_sub_ps(_mm_setr_ps(p[0].X, p[1].X, p[2].X, p[3].X), ox);
+            const __m128 y = _mm_sub_ps(_mm_setr_ps(p[0].Y, p[1].Y, p[2].Y, p[3].Y), oy);
+            const __m128 weightedX = _mm_mul_ps(weight, x);
+            const __m128 weightedY = _mm_mul_ps(weight, y);
+
+            sw = _mm_add_ps(sw, weight);
+            swx = _mm_add_ps(swx, weightedX);
+            swy = _mm_add_ps(swy, weightedY);
+            swxx = _mm_add_ps(swxx, _mm_mul_ps(weightedX, x));
+            swxy = _mm_add_ps(swxy, _mm_mul_ps(weightedX, y));
+            swyy = _mm_add_ps(swyy, _mm_mul_ps(weightedY, y));
+        }
+
+        alignas(16) float lanes[6][4];
+        _mm_store_ps(lanes[0], sw);
+        _mm_store_ps(lanes[1], swx);
+        _mm_store_ps(lanes[2], swy);
+        _mm_store_ps(lanes[3], swxx);
+        _mm_store_ps(lanes[4], swxy);
+        _mm_store_ps(lanes[5], swyy);
+        for (int lane = 0; lane < 4; lane++) {
+            w += lanes[0][lane];
+            wx += lanes[1][lane];
+            wy += lanes[2][lane];
+            wxx += lanes[3][lane];
+            wxy += lanes[4][lane];
+            wyy += lanes[5][lane];
+        }
+#endif
+    }
+
+    for (; index < count; index++) {
+        const double weight = points[index].Sensitivity;
+        const double x = double(points[index].X - originX);
+        const double y = double(points[index].Y - originY);
+
+        w += weight;
+        wx += weight * x;
+        wy += weight * y;
+        wxx += weight * x * x;
+        wxy += weight * x * y;
+        wyy += weight * y * y;
+    }
+
+    return finish(w, wx, wy, wxx, wxy, wyy, originX, originY);
+}
+
+
+void thresholdMask(const unsigned short* cells, std::size_t count,
+                   unsigned short threshold, std::uint8_t* mask) {
+    thresholdMaskOf(cells, count, threshold, mask, true);
+}
+
+
+auto compactCells(const unsigned short* cells, std::size_t count, unsigned short threshold,
+                  std::uint32_t* indices, unsigned short* values) -> std::size_t {
+    return compactCellsOf(cells, count, threshold, indices, values, true);
+}
+
+
+void subtractBaseline(const unsigned short* cells, std::size_t count,
+                      float* mean, float* variance,
+                      float rate, float sigmas, float floor,
+                      unsigned short* signal) {
+    subtractBaselineOf(cells, count, mean, variance, rate, sigmas, floor, signal, true);
+}
+
+
+auto gridMoments(const unsigned short* cells, int stride,
+                 int x0, int y0, int x1, int y1,
+                 unsigned short threshold) -> Moments {
+    return gridMomentsOf(cells, stride, x0, y0, x1, y1, threshold, true);
+}
+
+
+auto pointMoments(const WacomMTBlobPoint* points, std::size_t count) -> Moments {
+    return pointMomentsOf(points, count, true);
+}
+
+
+namespace Scalar {
+
+void thresholdMask(const unsigned short* cells, std::size_t count,
+                   unsigned short threshold, std::uint8_t* mask) {
+    thresholdMaskOf(cells, count, threshold, mask, false);
+}
+
+
+auto compactCells(const unsigned short* cells, std::size_t count, unsigned short threshold,
+                  std::uint32_t* indices, unsigned short* values) -> std::size_t {
+    return compactCellsOf(cells, count, threshold, indices, values, false);
+}
+
+
+void subtractBaseline(const unsigned short* cells, std::size_t count,
+                      float* mean, float* variance,
+                      float rate, float sigmas, float floor,
+                      unsigned short* signal) {
+    subtractBaselineOf(cells, count, mean, variance, rate, sigmas, floor, signal, false);
+}
+
+
+auto gridMoments(const unsigned short* cells, int stride,
+                 int x0, int y0, int x1, int y1,
+                 unsigned short threshold) -> Moments {
+    return gridMomentsOf(cells, stride, x0, y0, x1, y1, threshold, false);
+}
+
+
+auto pointMoments(const WacomMTBlobPoint* points, std::size_t count) -> Moments {
+    return pointMomentsOf(points, count, false);
+}
+
+}
+
+
+// The Scribble sample's `DrawRawData`, less the drawing: every cell
+// is visited, and those above 4 are kept
+static auto scribbleRawCells(const unsigned short* cells, int width, int height,
+                             std::uint32_t* indices, unsigned short* values) -> std::size_t {
+    std::size_t found = 0;
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const std::uint32_t index = std::uint32_t(y * width + x);
+            const unsigned short value = cells[index];
+
+            if (value > 4) {
+                indices[found] = index;
+                values[found] = value;
+                found++;
+            }
+        }
+    }
+
+    return found;
+}
+
+
+// The same walk, summing a weighted centroid like `FindCenterPoint`
+static auto scribbleRawCenter(const unsigned short* cells, int width, int height) -> Moments {
+    std::uint32_t sumX = 0, sumY = 0, sumWeight = 0;
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const unsigned short value = cells[y * width + x];
+            if (value <= 4) continue;
+
+            sumX += std::uint32_t(x) * value;
+            sumY += std::uint32_t(y) * value;
+            sumWeight += value;
+        }
+    }
+
+    Moments center;
+    if (!sumWeight) return center;
+
+    center.weight = sumWeight;
+    center.x = sumX / sumWeight;
+    center.y = sumY / sumWeight;
+    return center;
+}
+
+
+// The Scribble sample's `FindCenterPoint`, in integers one point at a time
+static auto scribbleCenterPoint(const WacomMTBlobPoint* points, std::size_t count) -> Moments {
+    std::uint32_t sumX = 0, sumY = 0, sumWeight = 0;
+
+    for (std::size_t index = 0; index < count; index++) {
+        sumX += std::uint32_t(points[index].X) * points[index].Sensitivity;
+        sumY += std::uint32_t(points[index].Y) * points[index].Sensitivity;
+        sumWeight += points[index].Sensitivity;
+    }
+
+    Moments center;
+    if (!sumWeight) return center;
+
+    center.weight = sumWeight;
+    center.x = sumX / sumWeight;
+    center.y = sumY / sumWeight;
+    return center;
+}
+
+
+// Where benchmark results end up, such that no call is optimised away
+static volatile double benchmarkSink { 0.0 };
+
+
+auto benchmarkKernels(int width, int height, std::size_t points, int iterations) -> std::vector<KernelTiming> {
+    using Clock = std::chrono::steady_clock;
+    const std::size_t count = std::size_t(width) * std::size_t(height);
+
+    // Noise of 0-4 throughout, the Scribble sample's threshold, and three touches
+    std::vector<unsigned short> cells(count);
+    std::uint32_t seed = 12345;
+    for (std::size_t index = 0; index < count; index++) {
+        seed = seed * 1664525u + 1013904223u;
+        cells[index] = (unsigned short)((seed >> 24) % 5);
+    }
+
+    const float touches[3][2] {
+        { width * 0.25f, height * 0.3f },
+        { width * 0.6f,  height * 0.5f },
+        { width * 0.8f,  height * 0.8f },
+    };
+
+    for (const auto& touch : touches) {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                const float dx = x - touch[0];
+                const float dy = y - touch[1];
+                const float value = 400.0f * std::exp(-(dx * dx + dy * dy) / 8.0f);
+                cells[std::size_t(y) * std::size_t(width) + std::size_t(x)] += (unsigned short)value;
+            }
+        }
+    }
+
+    // A contour in screen coordinates, much like the SDK's blob points
+    std::vector<WacomMTBlobPoint> contour(points);
+    for (std::size_t index = 0; index < points; index++) {
+        const float angle = 6.2831853f * index / float(points);
+        contour[index].X = 900.0f + 40.0f * std::cos(angle);
+        contour[index].Y = 500.0f + 25.0f * std::sin(angle);
+        contour[index].Sensitivity = (unsigned short)(100 + index % 50);
+    }
+
+    std::vector<std::uint8_t> mask(count);
+    std::vector<std::uint32_t> indices(count);
+    std::vector<unsigned short> values(count);
+    std::vector<unsigned short> signal(count);
+    std::vector<float> mean(count, 2.0f);
+    std::vector<float> variance(count, 2.0f);
+
+    double sink { 0.0 };
+
+    const auto time = [iterations](auto function) {
+        const auto start = Clock::now();
+        for (int iteration = 0; iteration < iterations; iteration++) function();
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / iterations;
+    };
+
+    std::vector<KernelTiming> timings;
+
+    {
+        KernelTiming timing { "thresholdMask" };
+        timing.scalar = time([&]{ Scalar::thresholdMask(cells.data(), count, 4, mask.data()); sink += mask[count / 2]; });
+        timing.vectorised = time([&]{ thresholdMask(cells.data(), count, 4, mask.data()); sink += mask[count / 2]; });
+        timings.push_back(timing);
+    }
+
+    {
+        KernelTiming timing { "compactCells" };
+        timing.scribble = time([&]{ sink += scribbleRawCells(cells.data(), width, height, indices.data(), values.data()); });
+        timing.scalar = time([&]{ sink += Scalar::compactCells(cells.data(), count, 4, indices.data(), values.data()); });
+        timing.vectorised = time([&]{ sink += compactCells(cells.data(), count, 4, indices.data(), values.data()); });
+        timings.push_back(timing);
+    }
+
+    {
+        KernelTiming timing { "subtractBaseline" };
+        timing.scalar = time([&]{
+            Scalar::subtractBaseline(cells.data(), count, mean.data(), variance.data(), 0.01f, 3.0f, 4.0f, signal.data());
+            sink += signal[count / 2];
+        });
+        timing.vectorised = time([&]{
+            subtractBaseline(cells.data(), count, mean.data(), variance.data(), 0.01f, 3.0f, 4.0f, signal.data());
+            sink += signal[count / 2];
+        });
+        timings.push_back(timing);
+    }
+
+    {
+        KernelTiming timing { "gridMoments" };
+        timing.scribble = time([&]{ sink += scribbleRawCenter(cells.data(), width, height).x; });
+        timing.scalar = time([&]{ sink += Scalar::gridMoments(cells.data(), width, 0, 0, width, height, 4).x; });
+        timing.vectorised = time([&]{ sink += gridMoments(cells.data(), width, 0, 0, width, height, 4).x; });
+        timings.push_back(timing);
+    }
+
+    {
+        KernelTiming timing { "pointMoments" };
+        timing.scribble = time([&]{ sink += scribbleCenterPoint(contour.data(), points).x; });
+        timing.scalar = time([&]{ sink += Scalar::pointMoments(contour.data(), points).x; });
+        timing.vectorised = time([&]{ sink += pointMoments(contour.data(), points).x; });
+        timings.push_back(timing);
+    }
+
+    benchmarkSink = sink;
+
+    return timings;
+}
+
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <WacomMultiTouchTypes.h>
+
+// Vectorised kernels for raw sensitivity grids and blob contours
+//
+// Built with AVX2 when the compiler targets it (e.g. /arch:AVX2, see
+// WACOM_AVX2 in CMakeLists.txt), SSE2 otherwise on x86 and plain C++
+// everywhere else. Every path returns the same results, and the plain
+// C++ one is always available under `Scalar`, e.g. to compare against.
+
+namespace Wacom {
+
+// Sensitivity-weighted moments of a set of cells or points
+struct Moments {
+    // Sum of sensitivities, 0 if nothing was above threshold
+    double weight { 0.0 };
+
+    // Weighted centroid
+    double x { 0.0 };
+    double y { 0.0 };
+
+    // Weighted central second moments, i.e. the covariance
+    double xx { 0.0 };
+    double xy { 0.0 };
+    double yy { 0.0 };
+};
+
+
+// Which SIMD path was compiled in, e.g. "AVX2"
+auto kernelPath() -> const char*;
+
+// 0xFF in `mask` for every cell above `threshold`, 0 otherwise
+void thresholdMask(const unsigned short* cells, std::size_t count,
+                   unsigned short threshold, std::uint8_t* mask);
+
+// Index and value of every cell above `threshold`, returns how many
+//
+// Both outputs must have room for `count` entries. Cheapest on
+// sparse grids, where most of the grid is skipped 8-16 cells at a time.
+auto compactCells(const unsigned short* cells, std::size_t count, unsigned short threshold,
+                  std::uint32_t* indices, unsigned short* values) -> std::size_t;
+
+// Subtract a per-cell baseline, keeping cells further above it than
+// `sigmas` standard deviations plus `floor`, and zeroing the rest
+//
+// Cells that aren't kept are assumed to be background, and fold into
+// the running `mean` and `variance` at `rate`, between 0-1.
+void subtractBaseline(const unsigned short* cells, std::size_t count,
+                      float* mean, float* variance,
+                      float rate, float sigmas, float floor,
+                      unsigned short* signal);
+
+// Moments of cells above `threshold` within [x0, x1) x [y0, y1) of a
+// row-major grid `stride` cells wide, in cell coordinates
+auto gridMoments(const unsigned short* cells, int stride,
+                 int x0, int y0, int x1, int y1,
+                 unsigned short threshold) -> Moments;
+
+// Moments of blob contour points, weighted by their sensitivity
+auto pointMoments(const WacomMTBlobPoint* points, std::size_t count) -> Moments;
+
+
+// The same kernels, without SIMD
+namespace Scalar {
+
+void thresholdMask(const unsigned short* cells, std::size_t count,
+                   unsigned short threshold, std::uint8_t* mask);
+auto compactCells(const unsigned short* cells, std::size_t count, unsigned short threshold,
+                  std::uint32_t* indices, unsigned short* values) -> std::size_t;
+void subtractBaseline(const unsigned short* cells, std::size_t count,
+                      float* mean, float* variance,
+                      float rate, float sigmas, float floor,
+                      unsigned short* signal);
+auto gridMoments(const unsigned short* cells, int stride,
+                 int x0, int y0, int x1, int y1,
+                 unsigned short threshold) -> Moments;
+auto pointMoments(const WacomMTBlobPoint* points, std::size_t count) -> Moments;
+
+}
+
+
+// Time taken by one call of a kernel
+struct KernelTiming {
+    const char* name;
+
+    // In microseconds, 0 where the Scribble sample has no equivalent
+    double scribble { 0.0 };
+    double scalar { 0.0 };
+    double vectorised { 0.0 };
+};
+
+// Of every kernel over a synthetic `width` x `height` grid with three
+// touches, and a contour of `points` blob points, averaged over `iterations`
+//
+// Compared against ports of the Scribble sample's `DrawRawData`, which
+// visits every cell testing `value > 4`, and its integer `FindCenterPoint`.
+auto benchmarkKernels(int width, int height, std::size_t points, int iterations) -> std::vector<KernelTiming>;
+
+}
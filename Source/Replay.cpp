@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <iostream>
+#include "Replay.h"
+
+
+namespace Wacom {
+
+
+Replay::Replay(Corrade::Containers::ArrayView<const RecordedFinger> session,
+               Pacing pacing, float speed, std::size_t queueCapacity)
+    : Touch(queueCapacity), _session(session), _pacing(pacing), _speed(speed) {
+
+    if (_pacing == Pacing::RealTime) _speed = 1.0f;
+}
+
+
+Replay::~Replay() {
+    _stop.store(true, std::memory_order_relaxed);
+    if (_thread.joinable()) _thread.join();
+}
+
+
+bool Replay::init() {
+    if (_thread.joinable()) return false;
+
+    _started = now();
+    _thread = std::thread(&Replay::_run, this);
+    return true;
+}
+
+
+void Replay::wait() {
+    if (_thread.joinable()) _thread.join();
+}
+
+
+void Replay::printAttachedDevices() const {
+    const auto pacing = _pacing == Pacing::RealTime ? "RealTime"
+                      : _pacing == Pacing::Accelerated ? "Accelerated"
+                      : "AsFastAsPossible";
+
+    std::cout << "Replay: "         << _session.size() << " fingers" << std::endl
+              << "Pacing: "         << pacing                        << std::endl
+              << "Speed: "          << _speed                        << std::endl;
+}
+
+
+auto Replay::packetsPerSecond() const -> double {
+    const Timestamp stopped = _stopped.load(std::memory_order_acquire);
+    const Timestamp elapsed = (stopped ? stopped : now()) - _started;
+    return elapsed > 0 ? this->packetCount() * 1.0e9 / elapsed : 0.0;
+}
+
+
+void Replay::_run() {
+    // Allocated once, grown only for unusually large packets
+    std::vector<WacomMTFinger> fingers;
+    fingers.reserve(DEFAULT_FINGER_MAX);
+
+    const Timestamp first = _session.empty() ? 0 : _session[0].timestamp;
+
+    std::size_t index = 0;
+    while (index < _session.size() && !_stop.load(std::memory_order_relaxed)) {
+        const RecordedFinger& header = _session[index];
+
+        // Tolerate truncated sessions, and packets without fingers
+        std::size_t count = header.fingerCount > 0 ? std::size_t(header.fingerCount) : 1;
+        if (count > _session.size() - index) count = _session.size() - index;
+
+        if (_pacing != Pacing::AsFastAsPossible) {
+            const auto offset = Timestamp((header.timestamp - first) / _speed);
+            std::this_thread::sleep_until(std::chrono::steady_clock::time_point{
+                std::chrono::nanoseconds{ _started + offset }
+            });
+        }
+
+        // Nothing to pace by, so keep up with `poll()` rather than overflow its queue;
+        // a packet may queue a synthesised Down or Up alongside each finger
+        else {
+            const std::size_t room = std::min(2 * count, this->queueCapacity());
+            while (this->queueCapacity() - this->queueSize() < room && !_stop.load(std::memory_order_relaxed)) {
+                std::this_thread::yield();
+            }
+        }
+
+        fingers.clear();
+        for (std::size_t ii = 0; ii < count; ii++) {
+            fingers.push_back(playback(_session[index + ii]));
+        }
+
+        WacomMTFingerCollection packet {};
+        packet.Version      = WACOM_MULTI_TOUCH_API_VERSION;
+        packet.DeviceID     = header.deviceId;
+        packet.FrameNumber  = header.frameNumber;
+        packet.FingerCount  = int(count);
+        packet.Fingers      = fingers.data();
+
+        this->_fingerCallBack(&packet);
+
+        _packets.fetch_add(1, std::memory_order_relaxed);
+        index += count;
+    }
+
+    _stopped.store(now(), std::memory_order_release);
+    _finished.store(true, std::memory_order_release);
+}
+
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <Corrade/Containers/ArrayView.h>
+
+#include "Session.h"
+#include "Wacom.h"
+
+namespace Wacom {
+
+enum class Pacing {
+    // As recorded
+    RealTime = 0,
+
+    // As recorded, but `speed` times faster
+    Accelerated,
+
+    // No waiting between packets, for measuring throughput, other than
+    // for room in the queue such that nothing is dropped
+    AsFastAsPossible
+};
+
+
+// Feed a recorded session through the same path as the Wacom SDK
+//
+// Packets are delivered to `_fingerCallBack()` from a thread of its own,
+// starting on `init()`. The session isn't copied, and must outlive this.
+class Replay : public Touch {
+public:
+    explicit Replay(Corrade::Containers::ArrayView<const RecordedFinger> session,
+                    Pacing pacing = Pacing::RealTime,
+                    float speed = 1.0f,
+                    std::size_t queueCapacity = DEFAULT_QUEUE_CAPACITY);
+    ~Replay() override;
+
+    bool init() override;
+    void printAttachedDevices() const override;
+
+    // Block until every packet has been delivered
+    void wait();
+    bool finished() const { return _finished.load(std::memory_order_acquire); }
+
+    auto packetCount() const -> std::size_t { return _packets.load(std::memory_order_relaxed); }
+
+    // Delivered packets per second of wall-clock time since `init()`
+    auto packetsPerSecond() const -> double;
+
+private:
+    Corrade::Containers::ArrayView<const RecordedFinger> _session;
+    Pacing _pacing;
+    float _speed;
+
+    std::thread _thread;
+    std::atomic<bool> _stop { false };
+    std::atomic<bool> _finished { false };
+    std::atomic<std::size_t> _packets { 0 };
+    Timestamp _started { 0 };
+    std::atomic<Timestamp> _stopped { 0 };
+
+    void _run();
+};
+
+}
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Resampler.h"
+
+namespace Wacom {
+
+
+Resampler::Resampler(std::size_t maxContacts) : _tracks(maxContacts) {
+    for (auto& track : _tracks) track.used = false;
+}
+
+
+auto Resampler::_find(int deviceId, FingerId fingerId) const -> const Track* {
+    for (const auto& track : _tracks) {
+        if (track.used && track.deviceId == deviceId && track.fingerId == fingerId) return &track;
+    }
+
+    return nullptr;
+}
+
+
+auto Resampler::_find(int deviceId, FingerId fingerId) -> Track* {
+    return const_cast<Track*>(static_cast<const Resampler*>(this)->_find(deviceId, fingerId));
+}
+
+
+void Resampler::update(const Samples& samples) {
+    for (const auto& sample : samples) this->update(sample);
+}
+
+
+void Resampler::update(const TouchEvent& sample) {
+    // Stand-ins for lost Ups, with nothing new to say about position
+    if (sample.synthesised && sample.state == TouchState::Up) return;
+
+    Track* track = this->_find(sample.deviceId, sample.fingerId);
+
+    // Keep lifted contacts around, such that their last moments still
+    // resample; the slot is reclaimed on the next Down, or when needed
+    if (!track || sample.state == TouchState::Down) {
+        if (!track) {
+            auto it = std::find_if(_tracks.begin(), _tracks.end(), [](const Track& t) { return !t.used; });
+
+            // Out of slots, take over whichever lifted longest ago
+            if (it == _tracks.end()) {
+                it = std::min_element(_tracks.begin(), _tracks.end(), [](const Track& a, const Track& b) {
+                    return a.samples[a.count - 1].timestamp < b.samples[b.count - 1].timestamp;
+                });
+            }
+
+            track = &*it;
+        }
+
+        track->deviceId = sample.deviceId;
+        track->fingerId = sample.fingerId;
+        track->used = true;
+        track->count = 0;
+    }
+
+    // Out of order, or a duplicate
+    if (track->count && track->samples[track->count - 1].timestamp >= sample.timestamp) return;
+
+    if (track->count == RESAMPLER_HISTORY) {
+        std::copy(track->samples + 1, track->samples + RESAMPLER_HISTORY, track->samples);
+        track->count--;
+    }
+
+    track->samples[track->count++] = {
+        sample.timestamp, sample.x, sample.y, sample.width, sample.height, sample.orientation
+    };
+}
+
+
+auto Resampler::resample(const TouchEvent& contact, Timestamp at) const -> TouchEvent {
+    TouchEvent resampled = contact;
+
+    const Track* track = this->_find(contact.deviceId, contact.fingerId);
+    if (!track || !track->count) return resampled;
+
+    const Sample* samples = track->samples;
+    const int count = track->count;
+
+    // First sample later than `at`, bounded to the ends of history
+    int next = 0;
+    while (next < count && samples[next].timestamp <= at) next++;
+
+    const Sample& a = samples[std::max(next - 1, 0)];
+    const Sample& b = samples[std::min(next, count - 1)];
+    const Timestamp span = b.timestamp - a.timestamp;
+    const float t = span > 0 ? float(at - a.timestamp) / float(span) : 0.0f;
+
+    // The short way round, e.g. from 179 to -179 degrees
+    float turn = std::fmod(b.orientation - a.orientation + 180.0f, 360.0f);
+    if (turn < 0.0f) turn += 360.0f;
+
+    resampled.x = a.x + (b.x - a.x) * t;
+    resampled.y = a.y + (b.y - a.y) * t;
+    resampled.width = a.width + (b.width - a.width) * t;
+    resampled.height = a.height + (b.height - a.height) * t;
+    resampled.orientation = a.orientation + (turn - 180.0f) * t;
+    resampled.timestamp = std::min(at, samples[count - 1].timestamp);
+
+    return resampled;
+}
+
+
+void Resampler::resample(Contacts& contacts, Timestamp at) {
+    Timestamp newest = std::numeric_limits<Timestamp>::min();
+
+    for (auto& contact : contacts) {
+        if (const Track* track = this->_find(contact.deviceId, contact.fingerId)) {
+            if (track->count) newest = std::max(newest, track->samples[track->count - 1].timestamp);
+        }
+
+        contact = this->resample(contact, at);
+    }
+
+    _staleness = contacts.empty() || newest == std::numeric_limits<Timestamp>::min() ? 0 : at - newest;
+}
+
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Wacom.h"
+
+#define RESAMPLER_HISTORY 8
+
+namespace Wacom {
+
+// Contacts as of any moment, rather than as of their latest sample
+//
+// Sensor and display run on clocks of their own, such that the latest
+// sample of each frame drawn is some arbitrary amount old. Feed this every
+// sample, e.g. `Touch::samples()`, and ask for contacts as of e.g. one
+// sensor frame ago; the samples either side are interpolated, for evenly
+// spaced positions on screen. Memory is allocated on construction only.
+class Resampler {
+public:
+    explicit Resampler(std::size_t maxContacts = DEFAULT_FINGER_MAX);
+
+    void update(const TouchEvent& sample);
+    void update(const Samples& samples);
+
+    // `contact` as of `at`, or as of its newest sample if `at` is later still
+    auto resample(const TouchEvent& contact, Timestamp at) const -> TouchEvent;
+
+    // Every contact in-place
+    void resample(Contacts& contacts, Timestamp at);
+
+    // How much older than `at` the newest sample of any contact was, as of
+    // the last `resample(Contacts&)`, in nanoseconds. Negative when that
+    // sample was newer, i.e. `at` fell between samples.
+    auto staleness() const -> Timestamp { return _staleness; }
+
+private:
+    struct Sample {
+        Timestamp timestamp;
+        float x, y, width, height, orientation;
+    };
+
+    struct Track {
+        int deviceId;
+        FingerId fingerId;
+        bool used;
+
+        // Oldest first
+        Sample samples[RESAMPLER_HISTORY];
+        int count;
+    };
+
+    std::vector<Track> _tracks;
+    Timestamp _staleness { 0 };
+
+    auto _find(int deviceId, FingerId fingerId) -> Track*;
+    auto _find(int deviceId, FingerId fingerId) const -> const Track*;
+};
+
+}
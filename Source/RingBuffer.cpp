@@ -0,0 +1,101 @@
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "RingBuffer.h"
+
+
+namespace Wacom {
+
+
+auto stress(std::size_t capacity, std::size_t count, std::size_t batch,
+            double rate, double period) -> RingStress {
+    using Clock = std::chrono::steady_clock;
+
+    // Sized like a finger sample, with a payload derived from the sequence
+    // number to spot values read while half-written
+    struct Sample {
+        std::uint64_t sequence;
+        std::uint64_t payload[7];
+    };
+
+    const auto payloadOf = [](std::uint64_t sequence, std::size_t index) {
+        return sequence * 0x9E3779B97F4A7C15ull + index;
+    };
+
+    RingBuffer<Sample> ring { capacity };
+    std::atomic<bool> done { false };
+    RingStress result;
+
+    const auto started = Clock::now();
+
+    std::thread producer { [&]() {
+        Sample sample {};
+        std::uint64_t sequence { 0 };
+
+        for (std::size_t packet = 0; sequence < count; packet++) {
+            if (rate > 0.0) {
+                std::this_thread::sleep_until(started + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(packet / rate)));
+            }
+
+            for (std::size_t index = 0; index < batch && sequence < count; index++, sequence++) {
+                sample.sequence = sequence;
+                for (std::size_t word = 0; word < 7; word++) sample.payload[word] = payloadOf(sequence, word);
+                ring.push(sample);
+            }
+        }
+
+        done.store(true, std::memory_order_release);
+    } };
+
+    // Next sequence number expected, anything skipped must have overflowed
+    std::uint64_t expected { 0 };
+    std::size_t skipped { 0 };
+    Sample sample;
+
+    for (std::size_t frame = 1;; frame++) {
+        const bool last = done.load(std::memory_order_acquire);
+
+        while (ring.pop(sample)) {
+            result.popped++;
+
+            for (std::size_t word = 0; word < 7; word++) {
+                if (sample.payload[word] != payloadOf(sample.sequence, word)) {
+                    result.torn++;
+                    break;
+                }
+            }
+
+            if (sample.sequence < expected) {
+                result.reordered++;
+                continue;
+            }
+
+            skipped += std::size_t(sample.sequence - expected);
+            expected = sample.sequence + 1;
+        }
+
+        if (last) break;
+
+        if (period > 0.0) {
+            std::this_thread::sleep_until(started + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(frame * period)));
+        }
+        else std::this_thread::yield();
+    }
+
+    producer.join();
+
+    // Dropped after the last value popped
+    skipped += std::size_t(count - expected);
+
+    result.pushed = count;
+    result.overflows = ring.overflowCount();
+    result.lost = skipped > result.overflows ? skipped - result.overflows : 0;
+    result.seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    return result;
+}
+
+
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace Wacom {
+
+// Bounded, wait-free single-producer/single-consumer queue
+//
+// Exactly one thread may `push()` and exactly one other thread may `pop()`.
+// Neither side ever blocks; when full, `push()` drops the value and counts
+// it as an overflow, such that a slow consumer can never stall the producer.
+//
+// Capacity is rounded up to the next power of two.
+//
+template<typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(std::size_t capacity) {
+        std::size_t size { 1 };
+        while (size < capacity) size <<= 1;
+
+        _buffer.resize(size);
+        _mask = size - 1;
+    }
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    // Producer side
+    bool push(const T& value) {
+        const auto head = _head.load(std::memory_order_relaxed);
+
+        if (head - _cachedTail > _mask) {
+            _cachedTail = _tail.load(std::memory_order_acquire);
+
+            if (head - _cachedTail > _mask) {
+                _overflows.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        _buffer[head & _mask] = value;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T& value) {
+        const auto tail = _tail.load(std::memory_order_relaxed);
+
+        if (tail == _cachedHead) {
+            _cachedHead = _head.load(std::memory_order_acquire);
+            if (tail == _cachedHead) return false;
+        }
+
+        value = _buffer[tail & _mask];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    auto capacity() const -> std::size_t { return _mask + 1; }
+
+    // Producer side, values that can be pushed without any overflowing;
+    // only ever grows until the next `push()`
+    auto room() const -> std::size_t {
+        return this->capacity() - (_head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire));
+    }
+
+    // Approximate when called concurrently with push/pop
+    auto size() const -> std::size_t {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    // Number of values dropped by `push()` due to a full queue
+    auto overflowCount() const -> std::size_t {
+        return _overflows.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::vector<T> _buffer;
+    std::size_t _mask { 0 };
+
+    // Keep producer and consumer state on separate cache lines
+    alignas(64) std::atomic<std::size_t> _head { 0 };
+    std::size_t _cachedTail { 0 };
+    std::atomic<std::size_t> _overflows { 0 };
+
+    alignas(64) std::atomic<std::size_t> _tail { 0 };
+    std::size_t _cachedHead { 0 };
+};
+
+
+// Outcome of `stress()`, every count but `overflows` should be 0
+struct RingStress {
+    std::size_t pushed { 0 };
+    std::size_t popped { 0 };
+    std::size_t overflows { 0 };
+
+    // Popped before a value pushed ahead of them, or more than once
+    std::size_t reordered { 0 };
+
+    // Popped with a payload other than the one pushed
+    std::size_t torn { 0 };
+
+    // Neither popped nor counted as an overflow
+    std::size_t lost { 0 };
+
+    // Wall-clock time, in seconds
+    double seconds { 0.0 };
+
+    bool ok() const { return reordered == 0 && torn == 0 && lost == 0 && popped + overflows == pushed; }
+};
+
+// Push `count` sequence numbers through a ring of `capacity` from one thread,
+// `batch` at a time at `rate` batches per second, or as fast as possible at 0
+//
+// Another thread pops every `period` seconds until the ring is empty,
+// like a render loop, or continuously at 0.
+auto stress(std::size_t capacity, std::size_t count, std::size_t batch,
+            double rate, double period) -> RingStress;
+
+}
@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <SDKDDKVer.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Session.h"
+
+
+namespace Wacom {
+
+
+static const char SessionMagic[4] { 'W', 'T', 'S', 'N' };
+static const char IndexMagic[4] { 'W', 'T', 'I', 'X' };
+static const std::uint32_t SessionVersion = 1;
+
+
+Recorder::Recorder(const std::string& path, std::size_t chunkSize, std::size_t queueCapacity)
+    : _queue(queueCapacity), _chunkSize(chunkSize ? chunkSize : 1) {
+
+    _file = std::fopen(path.c_str(), "wb");
+
+    if (!_file) {
+        std::cerr << "Couldn't open " << path << " for recording\n";
+        return;
+    }
+
+    SessionHeader header {};
+    std::memcpy(header.magic, SessionMagic, sizeof(SessionMagic));
+    header.version = SessionVersion;
+    header.recordSize = sizeof(RecordedFinger);
+    header.chunkSize = std::uint32_t(_chunkSize);
+    std::fwrite(&header, sizeof(header), 1, _file);
+
+    _chunk.reserve(_chunkSize);
+    _writer = std::thread(&Recorder::_run, this);
+}
+
+
+Recorder::~Recorder() {
+    if (!_file) return;
+
+    _stop.store(true, std::memory_order_release);
+    _writer.join();
+
+    SessionTrailer trailer {};
+    trailer.indexOffset = std::uint64_t(sizeof(SessionHeader) + _written.load() * sizeof(RecordedFinger));
+    trailer.chunkCount = _index.size();
+    std::memcpy(trailer.magic, IndexMagic, sizeof(IndexMagic));
+
+    std::fwrite(_index.data(), sizeof(ChunkInfo), _index.size(), _file);
+    std::fwrite(&trailer, sizeof(trailer), 1, _file);
+    std::fclose(_file);
+}
+
+
+void Recorder::record(const WacomMTFingerCollection& packet, Timestamp timestamp) {
+    if (!_file) return;
+
+    // Replay regroups records by `fingerCount`, so part of a packet would
+    // misalign every packet after it
+    if (_queue.room() < std::size_t(std::max(packet.FingerCount, 0))) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    for (int index = 0; index < packet.FingerCount; index++) {
+        _queue.push(Wacom::record(packet, index, timestamp));
+    }
+}
+
+
+void Recorder::_run() {
+    RecordedFinger finger;
+
+    for (;;) {
+        // Read before draining, such that nothing pushed before `_stop` is missed
+        const bool stopping = _stop.load(std::memory_order_acquire);
+
+        while (_queue.pop(finger)) {
+            _chunk.push_back(finger);
+            if (_chunk.size() == _chunkSize) this->_flush();
+        }
+
+        if (stopping) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    this->_flush();
+}
+
+
+void Recorder::_flush() {
+    if (_chunk.empty()) return;
+
+    ChunkInfo info {};
+    info.first = _written.load(std::memory_order_relaxed);
+    info.count = _chunk.size();
+    info.firstTimestamp = _chunk.front().timestamp;
+    info.lastTimestamp = _chunk.back().timestamp;
+    info.firstFrame = _chunk.front().frameNumber;
+    info.lastFrame = _chunk.back().frameNumber;
+
+    std::fwrite(_chunk.data(), sizeof(RecordedFinger), _chunk.size(), _file);
+
+    _index.push_back(info);
+    _written.fetch_add(_chunk.size(), std::memory_order_relaxed);
+    _chunk.clear();
+}
+
+
+Reader::Reader(const std::string& path) {
+#ifdef _WIN32
+    _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (_file == INVALID_HANDLE_VALUE) { _file = nullptr; }
+
+    LARGE_INTEGER size {};
+    if (_file && GetFileSizeEx(_file, &size) && size.QuadPart > 0) {
+        _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_mapping) {
+            _data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+            _size = std::size_t(size.QuadPart);
+        }
+    }
+#else
+    const int file = ::open(path.c_str(), O_RDONLY);
+    struct stat info {};
+
+    if (file != -1 && ::fstat(file, &info) == 0 && info.st_size > 0) {
+        void* data = ::mmap(nullptr, std::size_t(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        if (data != MAP_FAILED) {
+            _data = static_cast<const char*>(data);
+            _size = std::size_t(info.st_size);
+        }
+    }
+
+    if (file != -1) ::close(file);
+#endif
+
+    if (!_data) {
+        std::cerr << "Couldn't open " << path << " for reading\n";
+        this->_close();
+        return;
+    }
+
+    const auto* header = reinterpret_cast<const SessionHeader*>(_data);
+
+    if (_size < sizeof(SessionHeader) ||
+        std::memcmp(header->magic, SessionMagic, sizeof(SessionMagic)) != 0 ||
+        header->version != SessionVersion ||
+        header->recordSize != sizeof(RecordedFinger)) {
+        std::cerr << path << " is not a recorded session\n";
+        this->_close();
+        return;
+    }
+
+    const char* records = _data + sizeof(SessionHeader);
+    std::size_t recordsSize = _size - sizeof(SessionHeader);
+
+    // A complete session ends with its index
+    const auto* trailer = _size >= sizeof(SessionHeader) + sizeof(SessionTrailer)
+        ? reinterpret_cast<const SessionTrailer*>(_data + _size - sizeof(SessionTrailer))
+        : nullptr;
+
+    if (trailer &&
+        std::memcmp(trailer->magic, IndexMagic, sizeof(IndexMagic)) == 0 &&
+        trailer->indexOffset >= sizeof(SessionHeader) &&
+        trailer->indexOffset + trailer->chunkCount * sizeof(ChunkInfo) + sizeof(SessionTrailer) == _size) {
+
+        recordsSize = std::size_t(trailer->indexOffset) - sizeof(SessionHeader);
+        _index = { reinterpret_cast<const ChunkInfo*>(_data + trailer->indexOffset),
+                   std::size_t(trailer->chunkCount) };
+    }
+
+    _fingers = { reinterpret_cast<const RecordedFinger*>(records),
+                 recordsSize / sizeof(RecordedFinger) };
+
+    // ..otherwise it was cut short, so rebuild the index
+    if (!_index.data()) {
+        const std::size_t chunkSize = header->chunkSize ? header->chunkSize : DEFAULT_CHUNK_SIZE;
+
+        for (std::size_t first = 0; first < _fingers.size(); first += chunkSize) {
+            const auto chunk = _fingers.slice(first, std::min(first + chunkSize, _fingers.size()));
+
+            ChunkInfo info {};
+            info.first = first;
+            info.count = chunk.size();
+            info.firstTimestamp = chunk.front().timestamp;
+            info.lastTimestamp = chunk.back().timestamp;
+            info.firstFrame = chunk.front().frameNumber;
+            info.lastFrame = chunk.back().frameNumber;
+            _rebuiltIndex.push_back(info);
+        }
+
+        _index = { _rebuiltIndex.data(), _rebuiltIndex.size() };
+    }
+}
+
+
+Reader::~Reader() {
+    this->_close();
+}
+
+
+void Reader::_close() {
+#ifdef _WIN32
+    if (_data) UnmapViewOfFile(_data);
+    if (_mapping) CloseHandle(_mapping);
+    if (_file) CloseHandle(_file);
+    _mapping = _file = nullptr;
+#else
+    if (_data) ::munmap(const_cast<char*>(_data), _size);
+#endif
+
+    _data = nullptr;
+    _size = 0;
+    _fingers = nullptr;
+    _index = nullptr;
+}
+
+
+auto Reader::chunk(std::size_t index) const -> Corrade::Containers::ArrayView<const RecordedFinger> {
+    const ChunkInfo& info = _index[index];
+    return _fingers.slice(std::size_t(info.first), std::size_t(info.first + info.count));
+}
+
+
+auto Reader::seek(Timestamp timestamp) const -> std::size_t {
+    // The first chunk that ends at or after `timestamp`..
+    const auto chunk = std::lower_bound(_index.begin(), _index.end(), timestamp,
+        [](const ChunkInfo& info, Timestamp timestamp) { return info.lastTimestamp < timestamp; }
+    );
+
+    if (chunk == _index.end()) return _fingers.size();
+
+    // ..and the first record within it
+    const auto records = this->chunk(std::size_t(chunk - _index.begin()));
+    const auto record = std::lower_bound(records.begin(), records.end(), timestamp,
+        [](const RecordedFinger& finger, Timestamp timestamp) { return finger.timestamp < timestamp; }
+    );
+
+    return std::size_t(record - _fingers.begin());
+}
+
+
+auto Reader::seekFrame(int frameNumber) const -> std::size_t {
+    const auto chunk = std::lower_bound(_index.begin(), _index.end(), frameNumber,
+        [](const ChunkInfo& info, int frameNumber) { return info.lastFrame < frameNumber; }
+    );
+
+    if (chunk == _index.end()) return _fingers.size();
+
+    const auto records = this->chunk(std::size_t(chunk - _index.begin()));
+    const auto record = std::lower_bound(records.begin(), records.end(), frameNumber,
+        [](const RecordedFinger& finger, int frameNumber) { return finger.frameNumber < frameNumber; }
+    );
+
+    return std::size_t(record - _fingers.begin());
+}
+
+
+}
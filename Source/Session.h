@@ -0,0 +1,216 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Corrade/Containers/ArrayView.h>
+
+#include "RingBuffer.h"
+#include "Wacom.h"
+
+#define DEFAULT_CHUNK_SIZE 4096
+#define DEFAULT_RECORDER_CAPACITY 65536
+
+namespace Wacom {
+
+// One finger of one recorded `WacomMTFingerCollection`
+//
+// A packet is stored as `fingerCount` consecutive records sharing
+// a `deviceId`, `frameNumber` and `timestamp`. Fixed size and free
+// of pointers, such that a session can be written and read as-is.
+struct RecordedFinger {
+    Timestamp timestamp;
+
+    std::int32_t deviceId;
+    std::int32_t frameNumber;
+    std::int32_t fingerCount;
+    std::int32_t fingerId;
+
+    float x;
+    float y;
+    float width;
+    float height;
+    float orientation;
+
+    std::uint16_t sensitivity;
+    std::uint8_t confidence;
+    std::uint8_t state;  // WacomMTFingerState
+};
+
+static_assert(sizeof(RecordedFinger) == 48, "RecordedFinger is part of the file format");
+
+
+inline auto record(const WacomMTFingerCollection& packet, int index, Timestamp timestamp) -> RecordedFinger {
+    const WacomMTFinger& finger = packet.Fingers[index];
+
+    RecordedFinger record;
+    record.timestamp    = timestamp;
+    record.deviceId     = packet.DeviceID;
+    record.frameNumber  = packet.FrameNumber;
+    record.fingerCount  = packet.FingerCount;
+    record.fingerId     = finger.FingerID;
+    record.x            = finger.X;
+    record.y            = finger.Y;
+    record.width        = finger.Width;
+    record.height       = finger.Height;
+    record.orientation  = finger.Orientation;
+    record.sensitivity  = finger.Sensitivity;
+    record.confidence   = finger.Confidence;
+    record.state        = std::uint8_t(finger.TouchState);
+    return record;
+}
+
+
+inline auto playback(const RecordedFinger& record) -> WacomMTFinger {
+    WacomMTFinger finger;
+    finger.FingerID     = record.fingerId;
+    finger.X            = record.x;
+    finger.Y            = record.y;
+    finger.Width        = record.width;
+    finger.Height       = record.height;
+    finger.Sensitivity  = record.sensitivity;
+    finger.Orientation  = record.orientation;
+    finger.Confidence   = record.confidence != 0;
+    finger.TouchState   = WacomMTFingerState(record.state);
+    return finger;
+}
+
+
+
+// A session on disk
+//
+//  SessionHeader
+//  RecordedFinger * N      written a chunk at a time, contiguous
+//  ChunkInfo * chunkCount  the index
+//  SessionTrailer
+//
+// Chunks are `chunkSize` consecutive records, the last one possibly
+// fewer. A session without a trailer, e.g. from a crash, is still
+// readable; the index is then rebuilt from the records on open.
+struct SessionHeader {
+    char magic[4];  // "WTSN"
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint32_t chunkSize;
+};
+
+
+struct ChunkInfo {
+    std::uint64_t first;  // Index of the first record
+    std::uint64_t count;
+    Timestamp firstTimestamp;
+    Timestamp lastTimestamp;
+    std::int32_t firstFrame;
+    std::int32_t lastFrame;
+};
+
+
+struct SessionTrailer {
+    std::uint64_t indexOffset;
+    std::uint64_t chunkCount;
+    char magic[4];  // "WTIX"
+    std::uint32_t reserved;
+};
+
+
+// Write every finger packet to disk, without blocking the caller
+//
+// `record()` only copies into a queue, a background thread does
+// the writing. Packets that don't fit the queue are dropped whole and
+// counted, rather than held up or cut short.
+class Recorder {
+public:
+    explicit Recorder(const std::string& path,
+                      std::size_t chunkSize = DEFAULT_CHUNK_SIZE,
+                      std::size_t queueCapacity = DEFAULT_RECORDER_CAPACITY);
+
+    // Writes what remains, along with the index
+    ~Recorder();
+
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    bool isOpen() const { return _file != nullptr; }
+
+    // Call from a single thread, e.g. the Wacom callback thread
+    void record(const WacomMTFingerCollection& packet, Timestamp timestamp);
+
+    auto recordedCount() const -> std::size_t { return _written.load(std::memory_order_relaxed); }
+
+    // Packets, rather than fingers, for lack of room in the queue
+    auto droppedCount() const -> std::size_t { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    RingBuffer<RecordedFinger> _queue;
+    std::FILE* _file { nullptr };
+    std::size_t _chunkSize;
+
+    // Only touched by the writer thread
+    std::vector<RecordedFinger> _chunk;
+    std::vector<ChunkInfo> _index;
+
+    std::thread _writer;
+    std::atomic<bool> _stop { false };
+    std::atomic<std::size_t> _written { 0 };
+    std::atomic<std::size_t> _dropped { 0 };
+
+    void _run();
+    void _flush();
+};
+
+
+// Memory-mapped, read-only view of a session on disk
+//
+// Opening is independent of session length, records are never copied.
+class Reader {
+public:
+    explicit Reader(const std::string& path);
+    ~Reader();
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    bool isOpen() const { return _data != nullptr; }
+
+    // The whole session, e.g. for `Replay`
+    auto fingers() const -> Corrade::Containers::ArrayView<const RecordedFinger> { return _fingers; }
+
+    auto chunkCount() const -> std::size_t { return _index.size(); }
+    auto chunk(std::size_t index) const -> Corrade::Containers::ArrayView<const RecordedFinger>;
+
+    // Index of the first record at or after `timestamp` or `frameNumber`,
+    // or `fingers().size()` if there is none. O(log n)
+    //
+    // Seeking by frame assumes frame numbers increase throughout,
+    // as they do for sessions of a single device.
+    auto seek(Timestamp timestamp) const -> std::size_t;
+    auto seekFrame(int frameNumber) const -> std::size_t;
+
+    // Everything from `seek(timestamp)` onwards
+    auto from(Timestamp timestamp) const -> Corrade::Containers::ArrayView<const RecordedFinger> {
+        return _fingers.suffix(this->seek(timestamp));
+    }
+
+private:
+    const char* _data { nullptr };
+    std::size_t _size { 0 };
+
+#ifdef _WIN32
+    void* _file { nullptr };
+    void* _mapping { nullptr };
+#endif
+
+    Corrade::Containers::ArrayView<const RecordedFinger> _fingers;
+    Corrade::Containers::ArrayView<const ChunkInfo> _index;
+
+    // Only used when the index needs rebuilding
+    std::vector<ChunkInfo> _rebuiltIndex;
+
+    void _close();
+};
+
+}
\ No newline at end of file
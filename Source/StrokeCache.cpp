@@ -0,0 +1,313 @@
+#include "StrokeCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <imgui_internal.h> // ImDrawListSharedData
+
+namespace Wacom {
+
+
+void StrokeCache::update(const Strokes& strokes, bool drawing, const ImDrawList& painter) {
+    // Vertices carry both the anti-aliasing fringe and the UV of the atlas' white pixel
+    const auto flags = painter.Flags & (ImDrawListFlags_AntiAliasedLines | ImDrawListFlags_AntiAliasedFill);
+    const auto whitePixel = painter._Data->TexUvWhitePixel;
+    if (flags != _flags || whitePixel.x != _whitePixel.x || whitePixel.y != _whitePixel.y) {
+        this->invalidate();
+        _flags = flags;
+        _whitePixel = whitePixel;
+
+        auto options = _options;
+        if (!(flags & ImDrawListFlags_AntiAliasedLines)) options.fringe = 0.0f;
+        _tessellator.setOptions(options);
+    }
+
+    // Find the first stroke no longer up to date, everything after it goes too
+    std::size_t stroke { 0 };
+    for (; stroke < std::min(_entries.size(), strokes.size()); stroke++) {
+        const auto& entry = _entries[stroke];
+        const auto count = strokes.points(stroke).size();
+
+        if (entry.radius != strokes.radius(stroke) ||
+            entry.color != strokes.color(stroke) ||
+            entry.fill != strokes.fill(stroke)) break;
+
+        // Finished strokes never change, and live ones only grow
+        if (entry.finished ? entry.pointCount != count : entry.pointCount > count) break;
+    }
+
+    this->_truncate(stroke);
+
+    for (stroke = 0; stroke < strokes.size(); stroke++) {
+        const bool finished = stroke + 1 < strokes.size() || !drawing;
+
+        if (stroke < _entries.size()) {
+            if (_entries[stroke].finished) continue;
+
+            // Once more, in one go
+            if (finished) this->_truncate(stroke);
+        }
+
+        if (finished) this->_build(strokes, stroke);
+        else this->_buildLive(strokes, stroke);
+    }
+}
+
+
+void StrokeCache::draw(ImDrawList& painter, std::size_t first) {
+    _skipped = 0;
+    if (first >= _entries.size()) return;
+
+    for (std::size_t at = _entries[first].firstPiece; at < _pieces.size(); at++) {
+        const auto& piece = _pieces[at];
+
+        // Without vertex offsets, every vertex of the draw list shares one 16-bit range
+        if (sizeof(ImDrawIdx) == 2 && !(painter.Flags & ImDrawListFlags_AllowVtxOffset) &&
+            painter._VtxCurrentIdx + piece.vertexCount >= (1 << 16)) {
+            _skipped++;
+            continue;
+        }
+
+        // May start a new command, resetting the current index
+        painter.PrimReserve(int(piece.indexCount), int(piece.vertexCount));
+        const auto base = painter._VtxCurrentIdx;
+
+        std::memcpy(painter._VtxWritePtr, _vertices.data() + piece.vertexOffset, piece.vertexCount * sizeof(ImDrawVert));
+        painter._VtxWritePtr += piece.vertexCount;
+        painter._VtxCurrentIdx += piece.vertexCount;
+
+        const auto* indices = _indices.data() + piece.indexOffset;
+        for (std::uint32_t index = 0; index < piece.indexCount; index++) {
+            painter.PrimWriteIdx(ImDrawIdx(base + indices[index]));
+        }
+    }
+}
+
+
+void StrokeCache::invalidate() {
+    this->_truncate(0);
+}
+
+
+void StrokeCache::setOptions(const TessellationOptions& options) {
+    if (options.join == _options.join &&
+        options.miterLimit == _options.miterLimit &&
+        options.fringe == _options.fringe &&
+        options.tolerance == _options.tolerance) return;
+
+    _options = options;
+
+    // Picked up along with the flags of the next draw list
+    _flags = -1;
+}
+
+
+void StrokeCache::_truncate(std::size_t stroke) {
+    if (stroke >= _entries.size()) return;
+
+    this->_dropPieces(_entries[stroke].firstPiece);
+    _entries.resize(stroke);
+}
+
+
+void StrokeCache::_dropPieces(std::size_t piece) {
+    if (piece >= _pieces.size()) return;
+
+    _vertices.resize(_pieces[piece].vertexOffset);
+    _indices.resize(_pieces[piece].indexOffset);
+    _pieces.resize(piece);
+}
+
+
+void StrokeCache::_build(const Strokes& strokes, std::size_t stroke) {
+    const auto points = strokes.points(stroke);
+
+    Entry entry;
+    entry.firstPiece = std::uint32_t(_pieces.size());
+    entry.pointCount = std::uint32_t(points.size());
+    entry.radius = strokes.radius(stroke);
+    entry.color = strokes.color(stroke);
+    entry.fill = strokes.fill(stroke);
+    entry.finished = true;
+
+    this->_tessellateAll(strokes, stroke);
+
+    entry.frozenPieceEnd = std::uint32_t(_pieces.size());
+    entry.frozenPoints = entry.pointCount;
+    _entries.push_back(entry);
+}
+
+
+void StrokeCache::_buildLive(const Strokes& strokes, std::size_t stroke) {
+    const auto points = strokes.points(stroke);
+
+    if (stroke == _entries.size()) {
+        Entry entry;
+        entry.firstPiece = std::uint32_t(_pieces.size());
+        entry.frozenPieceEnd = entry.firstPiece;
+        entry.frozenPoints = 0;
+        entry.radius = strokes.radius(stroke);
+        entry.color = strokes.color(stroke);
+        entry.fill = strokes.fill(stroke);
+        entry.finished = false;
+        _entries.push_back(entry);
+    }
+
+    auto& entry = _entries[stroke];
+    entry.pointCount = std::uint32_t(points.size());
+
+    // A fill is one shape, there is no tail to it
+    if (entry.fill) {
+        this->_dropPieces(entry.firstPiece);
+        this->_tessellateAll(strokes, stroke);
+        return;
+    }
+
+    // Rebuild the tail alone, freezing it as it grows
+    this->_dropPieces(entry.frozenPieceEnd);
+
+    std::size_t start = entry.frozenPoints > 0 ? entry.frozenPoints - 1 : 0;
+    while (points.size() - start > STROKE_CACHE_LIVE_PIECE) {
+        const auto end = start + STROKE_CACHE_LIVE_PIECE;
+        this->_tessellate(strokes, stroke, start, end);
+
+        entry.frozenPieceEnd = std::uint32_t(_pieces.size());
+        entry.frozenPoints = std::uint32_t(end);
+        start = end - 1;
+    }
+
+    this->_tessellate(strokes, stroke, start, points.size());
+}
+
+
+void StrokeCache::_tessellateAll(const Strokes& strokes, std::size_t stroke) {
+    const auto count = strokes.points(stroke).size();
+    if (count == 0) return;
+
+    if (strokes.fill(stroke)) {
+        this->_tessellateFill(strokes, stroke);
+        return;
+    }
+
+    // Neighbouring pieces share a point, such that the line is unbroken
+    std::size_t start { 0 };
+    do {
+        const auto end = std::min(start + STROKE_CACHE_PIECE, count);
+        this->_tessellate(strokes, stroke, start, end);
+        start = end - 1;
+    } while (start + 1 < count);
+}
+
+
+void StrokeCache::_tessellate(const Strokes& strokes, std::size_t stroke, std::size_t start, std::size_t end) {
+    if (end - start < 1) return;
+
+    const auto points = strokes.points(stroke).slice(start, end);
+    const auto color = strokes.color(stroke);
+
+    Piece piece;
+    piece.vertexOffset = std::uint32_t(_vertices.size());
+    piece.indexOffset = std::uint32_t(_indices.size());
+
+    _tessellator.tessellate(points, strokes.widths(stroke).slice(start, end), color, _whitePixel,
+                            _vertices, _indices);
+
+    piece.vertexCount = std::uint32_t(_vertices.size()) - piece.vertexOffset;
+    piece.indexCount = std::uint32_t(_indices.size()) - piece.indexOffset;
+    if (piece.vertexCount > 0) _pieces.push_back(piece);
+}
+
+
+void StrokeCache::_tessellateFill(const Strokes& strokes, std::size_t stroke) {
+    const auto points = strokes.points(stroke);
+    const auto count = points.size();
+    if (count < 3) return;
+
+    const auto color = strokes.color(stroke);
+    const auto clear = color & ~IM_COL32_A_MASK;
+    const bool antiAliased = _flags & ImDrawListFlags_AntiAliasedFill;
+
+    // As ImDrawList::AddConvexPolyFilled() would, per point an inner vertex
+    // and, anti-aliased, an outer one half a pixel either side of the edge
+    if (antiAliased) {
+        _normals.resize(count);
+        _offsets.resize(count);
+
+        for (std::size_t i0 = count - 1, i1 = 0; i1 < count; i0 = i1++) {
+            auto diff = ImVec2{ points[i1].x - points[i0].x, points[i1].y - points[i0].y };
+            const float length2 = diff.x * diff.x + diff.y * diff.y;
+            const float inverse = length2 > 0.0f ? 1.0f / std::sqrt(length2) : 1.0f;
+            _normals[i0] = ImVec2{ diff.y * inverse, -diff.x * inverse };
+        }
+
+        for (std::size_t i0 = count - 1, i1 = 0; i1 < count; i0 = i1++) {
+            auto offset = ImVec2{ (_normals[i0].x + _normals[i1].x) * 0.5f,
+                                  (_normals[i0].y + _normals[i1].y) * 0.5f };
+            const float length2 = offset.x * offset.x + offset.y * offset.y;
+            const float scale = (length2 > 0.000001f ? std::min(1.0f / length2, 100.0f) : 1.0f) * 0.5f;
+            _offsets[i1] = ImVec2{ offset.x * scale, offset.y * scale };
+        }
+    }
+
+    const int stride = antiAliased ? 2 : 1;
+    const auto vertex = [&](std::size_t point) {
+        const auto& p = points[point];
+
+        if (antiAliased) {
+            const auto& d = _offsets[point];
+            _vertices.push_back({ ImVec2{ p.x - d.x, p.y - d.y }, _whitePixel, color });
+            _vertices.push_back({ ImVec2{ p.x + d.x, p.y + d.y }, _whitePixel, clear });
+        }
+        else {
+            _vertices.push_back({ p, _whitePixel, color });
+        }
+    };
+
+    // Fringe of the edge from `i0` to `i1`, by index within the piece
+    const auto fringe = [this](int i0, int i1) {
+        const ImDrawIdx indices[] {
+            ImDrawIdx(i1 * 2), ImDrawIdx(i0 * 2), ImDrawIdx(i0 * 2 + 1),
+            ImDrawIdx(i0 * 2 + 1), ImDrawIdx(i1 * 2 + 1), ImDrawIdx(i1 * 2),
+        };
+        _indices.insert(_indices.end(), std::begin(indices), std::end(indices));
+    };
+
+    // One fan from point 0, cut into pieces that each repeat point 0 and
+    // overlap by one point, such that each fits 16-bit indices
+    std::size_t start { 1 };
+    while (start + 1 < count) {
+        const auto end = std::min(start + STROKE_CACHE_PIECE, count);
+
+        Piece piece;
+        piece.vertexOffset = std::uint32_t(_vertices.size());
+        piece.indexOffset = std::uint32_t(_indices.size());
+
+        vertex(0);
+        for (std::size_t point = start; point < end; point++) vertex(point);
+
+        // Point 0 is index 0, `start` is index 1 and so forth
+        const int last = int(end - start);
+        for (int index = 2; index <= last; index++) {
+            const ImDrawIdx triangle[] {
+                0, ImDrawIdx((index - 1) * stride), ImDrawIdx(index * stride)
+            };
+            _indices.insert(_indices.end(), std::begin(triangle), std::end(triangle));
+        }
+
+        if (antiAliased) {
+            if (start == 1) fringe(0, 1);
+            for (int index = 2; index <= last; index++) fringe(index - 1, index);
+            if (end == count) fringe(last, 0);
+        }
+
+        piece.vertexCount = std::uint32_t(_vertices.size()) - piece.vertexOffset;
+        piece.indexCount = std::uint32_t(_indices.size()) - piece.indexOffset;
+        _pieces.push_back(piece);
+
+        start = end - 1;
+    }
+}
+
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <imgui.h>
+
+#include "StrokeTessellator.h"
+#include "Strokes.h"
+
+// Points per piece of a finished stroke, keeping each within 16-bit indices
+// even with every point a round join
+#define STROKE_CACHE_PIECE 1024
+
+// Points after which the tail of a live stroke is frozen
+#define STROKE_CACHE_LIVE_PIECE 64
+
+namespace Wacom {
+
+// Strokes tessellated once, rather than every frame
+//
+// Lines come from StrokeTessellator, as wide as the contact at each point.
+// Fills are what ImDrawList::AddConvexPolyFilled() would have made of
+// them, one fan from the first point. Either is copied into the draw list
+// being drawn to.
+//
+// A stroke is made of pieces, each indexed from 0 such that they fit
+// 16-bit indices wherever they end up, and overlapping by one point with
+// round caps in between; pieces of a fill also share its first point.
+// Only the live stroke, the last one, is ever rebuilt, and only its
+// unfrozen tail; once finished it is tessellated once more in pieces as
+// long as they can be.
+//
+// Changes to the color, radius or fill of a stroke rebuild it and every
+// stroke after it. A change in options, anti-aliasing or font atlas
+// rebuilds all.
+//
+class StrokeCache {
+public:
+    // Catch up with `strokes`, the last one being live whilst `drawing`
+    void update(const Strokes& strokes, bool drawing, const ImDrawList& painter);
+
+    // Append cached geometry to `painter`, of strokes from `first` onwards
+    void draw(ImDrawList& painter, std::size_t first = 0);
+
+    // E.g. on a change of view
+    void invalidate();
+
+    // Of lines, the fringe is only used when `painter` is anti-aliased
+    void setOptions(const TessellationOptions& options);
+    auto options() const -> const TessellationOptions& { return _options; }
+
+    auto vertexCount() const -> std::size_t { return _vertices.size(); }
+    auto indexCount() const -> std::size_t { return _indices.size(); }
+    auto pieceCount() const -> std::size_t { return _pieces.size(); }
+
+    // Pieces not drawn for lack of 16-bit indices, as of the last `draw()`
+    auto skippedCount() const -> std::size_t { return _skipped; }
+
+private:
+    struct Piece {
+        std::uint32_t vertexOffset;
+        std::uint32_t vertexCount;
+        std::uint32_t indexOffset;
+        std::uint32_t indexCount;
+    };
+
+    struct Entry {
+        std::uint32_t firstPiece;
+        std::uint32_t frozenPieceEnd;  // Pieces of a live stroke left alone
+        std::uint32_t frozenPoints;    // Points covered by those
+        std::uint32_t pointCount;
+        float radius;
+        ImU32 color;
+        bool fill;
+        bool finished;
+    };
+
+    void _truncate(std::size_t stroke);
+    void _dropPieces(std::size_t piece);
+    void _build(const Strokes& strokes, std::size_t stroke);
+    void _buildLive(const Strokes& strokes, std::size_t stroke);
+    void _tessellateAll(const Strokes& strokes, std::size_t stroke);
+    void _tessellateFill(const Strokes& strokes, std::size_t stroke);
+    void _tessellate(const Strokes& strokes, std::size_t stroke, std::size_t start, std::size_t end);
+
+    std::vector<ImDrawVert> _vertices;
+    std::vector<ImDrawIdx> _indices;
+    std::vector<Piece> _pieces;
+    std::vector<Entry> _entries;
+
+    // Per point of a fill, reused between fills
+    std::vector<ImVec2> _normals;
+    std::vector<ImVec2> _offsets;
+
+    // What the cached geometry was made with
+    StrokeTessellator _tessellator;
+    TessellationOptions _options;
+    ImDrawListFlags _flags { 0 };
+    ImVec2 _whitePixel { 0.0f, 0.0f };
+
+    std::size_t _skipped { 0 };
+};
+
+}
@@ -0,0 +1,367 @@
+#include "StrokeTessellator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <imgui_internal.h> // ImDrawListSharedData
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WACOM_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+// Joins turning less than this, as a cosine, are mitered even when round
+#define TESSELLATOR_ROUND_COS 0.99f
+
+namespace Wacom {
+
+static const float Pi { 3.14159265358979f };
+
+
+void StrokeTessellator::tessellate(Corrade::Containers::ArrayView<const ImVec2> points,
+                                   Corrade::Containers::ArrayView<const float> widths,
+                                   ImU32 color, ImVec2 whitePixel,
+                                   std::vector<ImDrawVert>& vertices,
+                                   std::vector<ImDrawIdx>& indices) {
+    const auto total = std::min(points.size(), widths.size());
+    if (total == 0) return;
+
+    // Coincident points have no direction, fold them into the one before
+    _x.resize(total);
+    _y.resize(total);
+    _half.resize(total);
+
+    std::size_t count { 0 };
+    for (std::size_t index = 0; index < total; index++) {
+        const auto& point = points[index];
+        const float half = widths[index] * 0.5f;
+
+        if (count > 0) {
+            const float dx = point.x - _x[count - 1];
+            const float dy = point.y - _y[count - 1];
+
+            if (dx * dx + dy * dy < 1.0e-6f) {
+                _half[count - 1] = std::max(_half[count - 1], half);
+                continue;
+            }
+        }
+
+        _x[count] = point.x;
+        _y[count] = point.y;
+        _half[count] = half;
+        count++;
+    }
+
+    _vertices = &vertices;
+    _indices = &indices;
+    _base = vertices.size();
+    _color = color;
+    _clear = color & ~IM_COL32_A_MASK;
+    _whitePixel = whitePixel;
+
+    // Mostly mitered, with both caps round
+    const std::size_t cap = 2 * TESSELLATOR_ROUND_SEGMENTS + 3;
+    vertices.reserve(vertices.size() + count * 4 + cap * 2);
+    indices.reserve(indices.size() + count * 18 + cap * 6);
+
+    // A dot
+    if (count == 1) {
+        this->_fan(_x[0], _y[0], 1.0f, 0.0f, 2.0f * Pi, _half[0]);
+        return;
+    }
+
+    this->_normals(count);
+    this->_miters(count);
+
+    const float limit = _options.miterLimit * _options.miterLimit;
+
+    // Round start, with the line continuing from its flat side
+    this->_fan(_x[0], _y[0], _nx[0], _ny[0], Pi, _half[0]);
+    auto previous = this->_pair(_x[0], _y[0], _nx[0], _ny[0], _half[0]);
+
+    for (std::size_t index = 1; index + 1 < count; index++) {
+        const float x = _x[index], y = _y[index], half = _half[index];
+        const float cos = _cos[index];
+
+        // Miter length over half the width, squared, is 2 / (1 + cos)
+        const bool round = (1.0f + cos) * limit < 2.0f ||
+                           (_options.join == StrokeJoin::Round && cos < TESSELLATOR_ROUND_COS);
+
+        if (!round) {
+            const auto current = this->_pair(x, y, _mx[index], _my[index], half);
+            this->_connect(previous, current);
+            previous = current;
+            continue;
+        }
+
+        // End one segment square, start the next square, round the outside in between
+        const float ax = _nx[index - 1], ay = _ny[index - 1];
+        const float bx = _nx[index], by = _ny[index];
+
+        const auto end = this->_pair(x, y, ax, ay, half);
+        this->_connect(previous, end);
+
+        const float cross = ax * by - ay * bx;
+        const float sweep = std::atan2(cross, cos);
+        if (cross < 0.0f) this->_fan(x, y, ax, ay, sweep, half);
+        else              this->_fan(x, y, -ax, -ay, sweep, half);
+
+        previous = this->_pair(x, y, bx, by, half);
+    }
+
+    const auto last = count - 1;
+    const float nx = _nx[last - 1], ny = _ny[last - 1];
+    const auto end = this->_pair(_x[last], _y[last], nx, ny, _half[last]);
+    this->_connect(previous, end);
+    this->_fan(_x[last], _y[last], -nx, -ny, Pi, _half[last]);
+}
+
+
+void StrokeTessellator::_normals(std::size_t count) {
+    const auto segments = count - 1;
+    _nx.resize(segments);
+    _ny.resize(segments);
+
+    std::size_t index { 0 };
+
+#if defined(WACOM_KERNELS_SSE2)
+    // Segments never have zero length, coincident points being folded already
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (; index + 4 <= segments; index += 4) {
+        const __m128 dx = _mm_sub_ps(_mm_loadu_ps(_x.data() + index + 1), _mm_loadu_ps(_x.data() + index));
+        const __m128 dy = _mm_sub_ps(_mm_loadu_ps(_y.data() + index + 1), _mm_loadu_ps(_y.data() + index));
+
+        const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+        const __m128 inverse = _mm_div_ps(one, length);
+
+        _mm_storeu_ps(_nx.data() + index, _mm_sub_ps(zero, _mm_mul_ps(dy, inverse)));
+        _mm_storeu_ps(_ny.data() + index, _mm_mul_ps(dx, inverse));
+    }
+#endif
+
+    for (; index < segments; index++) {
+        const float dx = _x[index + 1] - _x[index];
+        const float dy = _y[index + 1] - _y[index];
+        const float inverse = 1.0f / std::sqrt(dx * dx + dy * dy);
+
+        _nx[index] = -dy * inverse;
+        _ny[index] = dx * inverse;
+    }
+}
+
+
+void StrokeTessellator::_miters(std::size_t count) {
+    _mx.resize(count);
+    _my.resize(count);
+    _cos.resize(count);
+
+    // Ends are square to their only segment
+    _mx[0] = _nx[0];
+    _my[0] = _ny[0];
+    _cos[0] = 1.0f;
+    _mx[count - 1] = _nx[count - 2];
+    _my[count - 1] = _ny[count - 2];
+    _cos[count - 1] = 1.0f;
+
+    // Of point `index`, in between segments `index - 1` and `index`
+    std::size_t index { 1 };
+
+#if defined(WACOM_KERNELS_SSE2)
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 epsilon = _mm_set1_ps(1.0e-6f);
+
+    for (; index + 4 < count; index += 4) {
+        const __m128 ax = _mm_loadu_ps(_nx.data() + index - 1);
+        const __m128 ay = _mm_loadu_ps(_ny.data() + index - 1);
+        const __m128 bx = _mm_loadu_ps(_nx.data() + index);
+        const __m128 by = _mm_loadu_ps(_ny.data() + index);
+
+        const __m128 cos = _mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by));
+        const __m128 denominator = _mm_add_ps(one, cos);
+
+        // A U-turn has no miter, and is always rounded
+        const __m128 valid = _mm_cmpgt_ps(denominator, epsilon);
+        const __m128 inverse = _mm_and_ps(valid, _mm_div_ps(one, _mm_max_ps(denominator, epsilon)));
+
+        _mm_storeu_ps(_mx.data() + index, _mm_mul_ps(_mm_add_ps(ax, bx), inverse));
+        _mm_storeu_ps(_my.data() + index, _mm_mul_ps(_mm_add_ps(ay, by), inverse));
+        _mm_storeu_ps(_cos.data() + index, cos);
+    }
+#endif
+
+    for (; index + 1 < count; index++) {
+        const float ax = _nx[index - 1], ay = _ny[index - 1];
+        const float bx = _nx[index], by = _ny[index];
+
+        const float cos = ax * bx + ay * by;
+        const float denominator = 1.0f + cos;
+        const float inverse = denominator > 1.0e-6f ? 1.0f / denominator : 0.0f;
+
+        _mx[index] = (ax + bx) * inverse;
+        _my[index] = (ay + by) * inverse;
+        _cos[index] = cos;
+    }
+}
+
+
+auto StrokeTessellator::_vertex(float x, float y, bool opaque) -> unsigned int {
+    const auto index = static_cast<unsigned int>(_vertices->size() - _base);
+
+    ImDrawVert vertex;
+    vertex.pos = ImVec2{ x, y };
+    vertex.uv = _whitePixel;
+    vertex.col = opaque ? _color : _clear;
+    _vertices->push_back(vertex);
+
+    return index;
+}
+
+
+// Left and right of a point, followed by their fringes when anti-aliased
+auto StrokeTessellator::_pair(float x, float y, float nx, float ny, float half) -> unsigned int {
+    const float fringe = _options.fringe;
+    const float core = std::max(half - fringe * 0.5f, 0.0f);
+
+    auto& vertices = *_vertices;
+    const auto size = vertices.size();
+    vertices.resize(size + (fringe > 0.0f ? 4 : 2));
+    ImDrawVert* out = vertices.data() + size;
+
+    out[0] = { ImVec2{ x + nx * core, y + ny * core }, _whitePixel, _color };
+    out[1] = { ImVec2{ x - nx * core, y - ny * core }, _whitePixel, _color };
+
+    if (fringe > 0.0f) {
+        const float outer = core + fringe;
+        out[2] = { ImVec2{ x + nx * outer, y + ny * outer }, _whitePixel, _clear };
+        out[3] = { ImVec2{ x - nx * outer, y - ny * outer }, _whitePixel, _clear };
+    }
+
+    return static_cast<unsigned int>(size - _base);
+}
+
+
+void StrokeTessellator::_connect(unsigned int from, unsigned int to) {
+    const bool fringe = _options.fringe > 0.0f;
+
+    auto& indices = *_indices;
+    const auto size = indices.size();
+    indices.resize(size + (fringe ? 18 : 6));
+    ImDrawIdx* out = indices.data() + size;
+
+    const auto quad = [&out](unsigned int a, unsigned int b, unsigned int c, unsigned int d) {
+        out[0] = ImDrawIdx(a); out[1] = ImDrawIdx(b); out[2] = ImDrawIdx(c);
+        out[3] = ImDrawIdx(a); out[4] = ImDrawIdx(c); out[5] = ImDrawIdx(d);
+        out += 6;
+    };
+
+    quad(from, from + 1, to + 1, to);
+
+    if (fringe) {
+        quad(from + 2, from, to, to + 2);
+        quad(from + 1, from + 3, to + 3, to + 1);
+    }
+}
+
+
+// Part of a circle, from normal `nx, ny` turning `sweep` radians
+void StrokeTessellator::_fan(float x, float y, float nx, float ny, float sweep, float half) {
+    const float fringe = _options.fringe;
+    const float core = std::max(half - fringe * 0.5f, 0.0f);
+    const float outer = core + fringe;
+
+    // As few segments as keep within tolerance of the circle
+    float step { Pi * 0.5f };
+    if (half > _options.tolerance) step = 2.0f * std::acos(1.0f - _options.tolerance / half);
+
+    const float turn = std::abs(sweep);
+    const int most = std::max(1, int(std::ceil(TESSELLATOR_ROUND_SEGMENTS * turn / Pi)));
+    const int segments = std::min(most, std::max(1, int(std::ceil(turn / std::max(step, 1.0e-3f)))));
+
+    const float angle = sweep / segments;
+    const float c = std::cos(angle), s = std::sin(angle);
+
+    auto& indices = *_indices;
+    const auto centre = this->_vertex(x, y, true);
+    auto rim = this->_vertex(x + nx * core, y + ny * core, true);
+    auto edge = fringe > 0.0f ? this->_vertex(x + nx * outer, y + ny * outer, false) : 0u;
+
+    for (int segment = 0; segment < segments; segment++) {
+        const float rx = nx * c - ny * s;
+        const float ry = nx * s + ny * c;
+        nx = rx;
+        ny = ry;
+
+        const auto nextRim = this->_vertex(x + nx * core, y + ny * core, true);
+        indices.insert(indices.end(), { ImDrawIdx(centre), ImDrawIdx(rim), ImDrawIdx(nextRim) });
+
+        if (fringe > 0.0f) {
+            const auto nextEdge = this->_vertex(x + nx * outer, y + ny * outer, false);
+            indices.insert(indices.end(), {
+                ImDrawIdx(rim), ImDrawIdx(edge), ImDrawIdx(nextEdge),
+                ImDrawIdx(rim), ImDrawIdx(nextEdge), ImDrawIdx(nextRim)
+            });
+            edge = nextEdge;
+        }
+
+        rim = nextRim;
+    }
+}
+
+
+auto benchmark(std::size_t points, const ImDrawListSharedData* data,
+               const TessellationOptions& options) -> StrokeBenchmark {
+    using Clock = std::chrono::steady_clock;
+    const auto milliseconds = [](Clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+
+    // A wobbly spiral, about half a pixel in between points
+    std::vector<ImVec2> positions(points);
+    std::vector<float> widths(points);
+    for (std::size_t index = 0; index < points; index++) {
+        const float t = index * 0.005f;
+        const float radius = 200.0f + 50.0f * std::sin(t * 0.37f);
+        positions[index] = ImVec2{ 500.0f + radius * std::cos(t), 500.0f + radius * std::sin(t) };
+        widths[index] = 8.0f + 6.0f * std::sin(index * 0.05f);
+    }
+
+    const ImU32 color = IM_COL32(255, 128, 0, 255);
+
+    StrokeBenchmark result;
+    result.points = points;
+
+    {
+        ImDrawList painter { data };
+        painter.Flags = ImDrawListFlags_AntiAliasedLines | ImDrawListFlags_AntiAliasedFill;
+        painter.PushClipRectFullScreen();
+        painter.PushTextureID(nullptr);
+
+        const auto start = Clock::now();
+        for (const auto& position : positions) painter.PathLineTo(position);
+        painter.PathStroke(color, false, 8.0f);
+        result.pathStroke = milliseconds(Clock::now() - start);
+        result.pathStrokeVertices = std::size_t(painter.VtxBuffer.Size);
+    }
+
+    {
+        StrokeTessellator tessellator;
+        tessellator.setOptions(options);
+
+        std::vector<ImDrawVert> vertices;
+        std::vector<ImDrawIdx> indices;
+
+        const auto start = Clock::now();
+        tessellator.tessellate({ positions.data(), positions.size() }, { widths.data(), widths.size() },
+                               color, data->TexUvWhitePixel, vertices, indices);
+        result.tessellator = milliseconds(Clock::now() - start);
+        result.tessellatorVertices = vertices.size();
+    }
+
+    return result;
+}
+
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <Corrade/Containers/ArrayView.h>
+#include <imgui.h>
+
+// Most segments of a round join or cap, per half turn
+#define TESSELLATOR_ROUND_SEGMENTS 16
+
+namespace Wacom {
+
+enum class StrokeJoin {
+    Miter = 0,  // Rounded beyond `miterLimit`
+    Round
+};
+
+
+struct TessellationOptions {
+    StrokeJoin join { StrokeJoin::Miter };
+
+    // Length of a miter over half the width, beyond which it is rounded instead
+    float miterLimit { 4.0f };
+
+    // Of the anti-aliased edge, in pixels, 0 for none
+    float fringe { 1.0f };
+
+    // Furthest a round join or cap may stray from a true circle, in pixels
+    float tolerance { 0.25f };
+};
+
+
+// Triangles of a stroke as wide as its contact at each point
+//
+// Unlike ImDrawList::PathStroke, every point has a width of its own,
+// turns are mitered or rounded rather than overlapping, and both ends are
+// rounded. Normals and miters are computed 4 points at a time with SSE2
+// where available; the rest is a single pass emitting an ImGui triangle
+// list, with an alpha fringe for anti-aliasing in place of ImGui's own.
+//
+class StrokeTessellator {
+public:
+    void setOptions(const TessellationOptions& options) { _options = options; }
+    auto options() const -> const TessellationOptions& { return _options; }
+
+    // Append a stroke through `points`, `widths` wide at each
+    //
+    // Indices start from the first vertex appended, such that the caller
+    // may place them anywhere, and are limited to ImDrawIdx like the rest
+    // of ImGui. Each point costs at most 8 vertices plus those of a round
+    // join, `TESSELLATOR_ROUND_SEGMENTS` * 2 + 3.
+    //
+    void tessellate(Corrade::Containers::ArrayView<const ImVec2> points,
+                    Corrade::Containers::ArrayView<const float> widths,
+                    ImU32 color, ImVec2 whitePixel,
+                    std::vector<ImDrawVert>& vertices,
+                    std::vector<ImDrawIdx>& indices);
+
+private:
+    void _normals(std::size_t count);
+    void _miters(std::size_t count);
+
+    auto _vertex(float x, float y, bool opaque) -> unsigned int;
+    auto _pair(float x, float y, float nx, float ny, float half) -> unsigned int;
+    void _connect(unsigned int from, unsigned int to);
+    void _fan(float x, float y, float nx, float ny, float sweep, float half);
+
+    TessellationOptions _options;
+
+    // Structure of arrays, for the vectorised passes
+    std::vector<float> _x, _y, _half;
+    std::vector<float> _nx, _ny;        // Of each segment
+    std::vector<float> _mx, _my, _cos;  // Of each point in between
+
+    // Of the call in progress
+    std::vector<ImDrawVert>* _vertices { nullptr };
+    std::vector<ImDrawIdx>* _indices { nullptr };
+    std::size_t _base { 0 };
+    ImU32 _color { 0 };
+    ImU32 _clear { 0 };
+    ImVec2 _whitePixel { 0.0f, 0.0f };
+};
+
+
+// Time taken by ImDrawList::PathStroke and StrokeTessellator for one stroke
+struct StrokeBenchmark {
+    std::size_t points { 0 };
+
+    // In milliseconds
+    double pathStroke { 0.0 };
+    double tessellator { 0.0 };
+
+    std::size_t pathStrokeVertices { 0 };
+    std::size_t tessellatorVertices { 0 };
+};
+
+// Of a synthetic stroke with `points` points of varying width
+//
+// Indices wrap beyond 64K vertices on either side, only time is measured.
+auto benchmark(std::size_t points, const ImDrawListSharedData* data,
+               const TessellationOptions& options) -> StrokeBenchmark;
+
+}
@@ -0,0 +1,122 @@
+#include "Strokes.h"
+
+namespace Wacom {
+
+
+auto Strokes::begin(float radius, ImU32 color, bool fill) -> std::size_t {
+    _offsets.push_back(std::uint32_t(_points.size()));
+    _lengths.push_back(0);
+    _rawLengths.push_back(0);
+    _radii.push_back(radius);
+    _colors.push_back(color);
+    _fills.push_back(fill ? 1 : 0);
+    return _offsets.size() - 1;
+}
+
+
+void Strokes::append(ImVec2 point, float width) {
+    if (_offsets.empty()) return;
+
+    _points.push_back(point);
+    _widths.push_back(width);
+    _lengths.back()++;
+    _rawLengths.back()++;
+    _rawPoints++;
+}
+
+
+auto Strokes::simplify(float tolerance) -> std::size_t {
+    if (_offsets.empty()) return 0;
+
+    const auto offset = _offsets.back();
+    const auto length = _lengths.back();
+    if (tolerance <= 0.0f || length < 3) return length;
+
+    ImVec2* points = _points.data() + offset;
+    float* widths = _widths.data() + offset;
+    const float squared = tolerance * tolerance;
+
+    _keep.assign(length, 0);
+    _keep.front() = _keep.back() = 1;
+
+    // Without recursion, such that long strokes cannot run out of stack
+    _ranges.clear();
+    _ranges.emplace_back(0, length - 1);
+
+    while (!_ranges.empty()) {
+        const auto [first, last] = _ranges.back();
+        _ranges.pop_back();
+
+        const ImVec2 a = points[first];
+        const ImVec2 ab { points[last].x - a.x, points[last].y - a.y };
+        const float abLength = ab.x * ab.x + ab.y * ab.y;
+
+        // Distance to the segment rather than the line, for strokes doubling back
+        float furthest { 0.0f };
+        std::uint32_t index { first };
+        for (auto at = first + 1; at < last; at++) {
+            ImVec2 ap { points[at].x - a.x, points[at].y - a.y };
+
+            if (abLength > 0.0f) {
+                float t = (ap.x * ab.x + ap.y * ab.y) / abLength;
+                t = t < 0.0f ? 0.0f : t > 1.0f ? 1.0f : t;
+                ap.x -= ab.x * t;
+                ap.y -= ab.y * t;
+            }
+
+            const float distance = ap.x * ap.x + ap.y * ap.y;
+            if (distance > furthest) {
+                furthest = distance;
+                index = at;
+            }
+        }
+
+        if (furthest <= squared) continue;
+
+        _keep[index] = 1;
+        if (index - first > 1) _ranges.emplace_back(first, index);
+        if (last - index > 1) _ranges.emplace_back(index, last);
+    }
+
+    std::uint32_t kept { 0 };
+    for (std::uint32_t at = 0; at < length; at++) {
+        if (!_keep[at]) continue;
+
+        points[kept] = points[at];
+        widths[kept] = widths[at];
+        kept++;
+    }
+
+    _points.resize(offset + kept);
+    _widths.resize(offset + kept);
+    _lengths.back() = kept;
+    return kept;
+}
+
+
+void Strokes::clear() {
+    _points.clear();
+    _widths.clear();
+    _offsets.clear();
+    _lengths.clear();
+    _rawLengths.clear();
+    _rawPoints = 0;
+    _radii.clear();
+    _colors.clear();
+    _fills.clear();
+}
+
+
+void Strokes::reserve(std::size_t strokes, std::size_t points) {
+    _points.reserve(points);
+    _widths.reserve(points);
+    _offsets.reserve(strokes);
+    _lengths.reserve(strokes);
+    _rawLengths.reserve(strokes);
+    _radii.reserve(strokes);
+    _colors.reserve(strokes);
+    _fills.reserve(strokes);
+}
+
+
+}
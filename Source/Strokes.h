@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <Corrade/Containers/ArrayView.h>
+#include <imgui.h>
+
+// In pixels, 0 keeps every point
+#define DEFAULT_SIMPLIFY_TOLERANCE 0.5f
+
+namespace Wacom {
+
+// Every stroke drawn, as columns rather than one allocation per stroke
+//
+// Points of all strokes share one pool, each stroke being a contiguous
+// range of it. Only the last, live, stroke is ever appended to, such that
+// its points stay contiguous too. Growing is amortised; once the pool is
+// big enough a frame costs nothing but the points it appends.
+class Strokes {
+public:
+    // Start a new live stroke, returns its index
+    auto begin(float radius, ImU32 color, bool fill) -> std::size_t;
+
+    // Add to the live stroke, `width` wide at this point
+    void append(ImVec2 point, float width);
+
+    // Drop points of the live stroke, once finished, returns how many remain
+    //
+    // Ramer-Douglas-Peucker, keeping every point further than `tolerance`
+    // from the line in between those kept. The live stroke being last in
+    // the pool, it shrinks in place.
+    //
+    auto simplify(float tolerance) -> std::size_t;
+
+    auto size() const -> std::size_t { return _offsets.size(); }
+    bool empty() const { return _offsets.empty(); }
+
+    // Of every stroke
+    auto pointCount() const -> std::size_t { return _points.size(); }
+
+    // Of every stroke as drawn, before `simplify()`
+    auto rawPointCount() const -> std::size_t { return _rawPoints; }
+
+    // Valid until the next `append()` or `begin()`
+    auto points(std::size_t stroke) const -> Corrade::Containers::ArrayView<const ImVec2> {
+        return { _points.data() + _offsets[stroke], _lengths[stroke] };
+    }
+
+    // One per point, alongside `points()`
+    auto widths(std::size_t stroke) const -> Corrade::Containers::ArrayView<const float> {
+        return { _widths.data() + _offsets[stroke], _lengths[stroke] };
+    }
+
+    // As drawn, before `simplify()`
+    auto rawSize(std::size_t stroke) const -> std::size_t { return _rawLengths[stroke]; }
+
+    auto radius(std::size_t stroke) const -> float { return _radii[stroke]; }
+    auto color(std::size_t stroke) const -> ImU32 { return _colors[stroke]; }
+    bool fill(std::size_t stroke) const { return _fills[stroke] != 0; }
+
+    // Keeps memory, for the next strokes
+    void clear();
+
+    void reserve(std::size_t strokes, std::size_t points);
+
+private:
+    std::vector<ImVec2> _points;
+    std::vector<float> _widths;
+
+    // One per stroke
+    std::vector<std::uint32_t> _offsets;
+    std::vector<std::uint32_t> _lengths;
+    std::vector<std::uint32_t> _rawLengths;
+    std::vector<float> _radii;
+    std::vector<ImU32> _colors;
+    std::vector<std::uint8_t> _fills;
+
+    std::size_t _rawPoints { 0 };
+
+    // For `simplify()`, kept in between calls
+    std::vector<std::uint8_t> _keep;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> _ranges;
+};
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace Wacom {
+
+// Somewhere finger packets come from
+//
+// A source delivers `WacomMTFingerCollection` packets, from a thread of
+// its own, to the same `Touch::_fingerCallBack()` the Wacom SDK calls.
+// That way everything downstream, from the queue to `poll()`, is the same
+// whether packets come from a tablet, a recording or a generator.
+class TouchSource {
+public:
+    virtual ~TouchSource() = default;
+
+    // Start delivering packets, returns false if that isn't possible
+    virtual bool init() = 0;
+    virtual void printAttachedDevices() const = 0;
+};
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Wacom {
+
+// Hand the newest of a stream of large values from one thread to another
+//
+// The producer fills `back()` and calls `publish()`, the consumer calls
+// `acquire()` and reads `front()`. Neither ever waits on the other, and
+// values are swapped rather than copied. Values published faster than
+// they are acquired are overwritten, only the newest is kept.
+//
+// Buffers are default-constructed; preallocate them via `each()`
+// before either side is running.
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    template<typename F>
+    void each(F function) {
+        for (auto& buffer : _buffers) function(buffer);
+    }
+
+    // Producer side
+    auto back() -> T& { return _buffers[_back]; }
+
+    void publish() {
+        const auto previous = _middle.exchange(std::uint8_t(_back | Fresh), std::memory_order_acq_rel);
+        _back = previous & Index;
+
+        // Replaced before the consumer got to it
+        if (previous & Fresh) _skipped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Consumer side, returns false if nothing new was published
+    bool acquire() {
+        if (!(_middle.load(std::memory_order_relaxed) & Fresh)) return false;
+
+        const auto previous = _middle.exchange(_front, std::memory_order_acq_rel);
+        _front = previous & Index;
+        return true;
+    }
+
+    auto front() const -> const T& { return _buffers[_front]; }
+
+    // Values published, but never acquired
+    auto skipped() const -> std::size_t { return _skipped.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::uint8_t Index = 0x3;
+    static constexpr std::uint8_t Fresh = 0x4;
+
+    T _buffers[3];
+
+    std::uint8_t _back { 0 };
+    std::atomic<std::uint8_t> _middle { 1 };
+    std::uint8_t _front { 2 };
+
+    std::atomic<std::size_t> _skipped { 0 };
+};
+
+}
@@ -1,10 +1,23 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#include <SDKDDKVer.h>
+#include <windows.h>
+#include <WacomMultiTouch.h>
+#endif
+
 #include "Wacom.h"
+#include "Session.h"
 
 
 namespace Wacom {
 
 
+#ifdef _WIN32
 static void OnAttached(WacomMTCapability deviceInfo, void *userInfo) {
     Touch* tablet = static_cast<Touch*>(userInfo);
     tablet->_deviceAttached(deviceInfo);
@@ -24,9 +37,158 @@ static int OnFinger(WacomMTFingerCollection *fingerPacket, void *userInfo) {
 }
 
 
+static int OnBlob(WacomMTBlobAggregate *blobPacket, void *userInfo) {
+    Touch* tablet = static_cast<Touch*>(userInfo);
+    tablet->_blobCallBack(blobPacket);
+    return 0;
+}
+
+
+static int OnRaw(WacomMTRawData *rawPacket, void *userInfo) {
+    Touch* tablet = static_cast<Touch*>(userInfo);
+    tablet->_rawCallBack(rawPacket);
+    return 0;
+}
+#endif
+
+
+auto JitterEstimator::update(int frameNumber, Timestamp arrival) -> Timestamp {
+    const int frames = frameNumber - _lastFrame;
+    const Timestamp interval = arrival - _lastArrival;
+    Timestamp jitter { 0 };
+
+    // A first packet, or a restarted/wrapped frame counter
+    if (_lastArrival == 0 || frames <= 0) {}
+
+    else {
+        auto period = _period.load(std::memory_order_relaxed);
+
+        if (period == 0) {
+            period = interval / frames;
+        }
+        else {
+            jitter = interval - frames * period;
+
+            // Exponential moving averages, like RFC 3550's interarrival jitter
+            period += (interval / frames - period) / 16;
+            const auto mean = _jitter.load(std::memory_order_relaxed);
+            _jitter.store(mean + ((jitter < 0 ? -jitter : jitter) - mean) / 16,
+                          std::memory_order_relaxed);
+        }
+
+        _period.store(period, std::memory_order_relaxed);
+    }
+
+    _lastFrame = frameNumber;
+    _lastArrival = arrival;
+
+    return jitter;
+}
+
+
+void JitterEstimator::reset() {
+    _lastFrame = 0;
+    _lastArrival = 0;
+    _period.store(0, std::memory_order_relaxed);
+    _jitter.store(0, std::memory_order_relaxed);
+}
+
+
+Contacts::Contacts(std::size_t capacity)
+    : _slots(new TouchEvent[capacity]), _capacity(capacity) {}
+
+
+auto Contacts::find(int deviceId, FingerId fingerId) -> TouchEvent* {
+    for (auto& event : *this) {
+        if (event.fingerId == fingerId && event.deviceId == deviceId) return &event;
+    }
+
+    return nullptr;
+}
+
+
+auto Contacts::find(int deviceId, FingerId fingerId) const -> const TouchEvent* {
+    for (auto& event : *this) {
+        if (event.fingerId == fingerId && event.deviceId == deviceId) return &event;
+    }
+
+    return nullptr;
+}
+
+
+auto Contacts::find(FingerId fingerId) -> TouchEvent* {
+    for (auto& event : *this) {
+        if (event.fingerId == fingerId) return &event;
+    }
+
+    return nullptr;
+}
+
+
+auto Contacts::find(FingerId fingerId) const -> const TouchEvent* {
+    for (auto& event : *this) {
+        if (event.fingerId == fingerId) return &event;
+    }
+
+    return nullptr;
+}
+
+
+auto Contacts::at(FingerId fingerId) -> TouchEvent& {
+    auto* event = this->find(fingerId);
+    if (!event) throw std::out_of_range("Contacts::at(): no such finger");
+    return *event;
+}
+
+
+auto Contacts::at(FingerId fingerId) const -> const TouchEvent& {
+    auto* event = this->find(fingerId);
+    if (!event) throw std::out_of_range("Contacts::at(): no such finger");
+    return *event;
+}
+
+
+auto Contacts::insert(const TouchEvent& event) -> TouchEvent* {
+    if (_size == _capacity) return nullptr;
+
+    _slots[_size] = event;
+    return &_slots[_size++];
+}
+
+
+void Contacts::erase(int deviceId, FingerId fingerId) {
+    auto* event = this->find(deviceId, fingerId);
+    if (!event) return;
+
+    *event = _slots[--_size];
+}
+
+
+void Contacts::reserve(std::size_t capacity) {
+    if (capacity <= _capacity) return;
+
+    std::unique_ptr<TouchEvent[]> slots { new TouchEvent[capacity] };
+    std::copy(this->begin(), this->end(), slots.get());
+
+    _slots = std::move(slots);
+    _capacity = capacity;
+}
+
+
+Touch::Touch(std::size_t queueCapacity) : _queue(queueCapacity) {
+    _samples.reserve(_queue.capacity());
+    _undrawn.reserve(DEFAULT_FINGER_MAX * 2);
+    _downs.reserve(DEFAULT_FINGER_MAX * 2);
+}
+
+
 bool Touch::init() {
     bool wasInitialised = false;
 
+#ifndef _WIN32
+    std::cerr << "The Wacom Feel SDK is only available on Windows\n";
+#else
+
     WacomMTError err = WacomMTInitialize(WACOM_MULTI_TOUCH_API_VERSION);
 
     if (err == WMTErrorSuccess) {
@@ -43,7 +205,7 @@ bool Touch::init() {
         int deviceIDs[MAX_ATTACHED_DEVICES]  = {};
         int deviceCount    = 0;
 
-        // Add a viewer for each device's data
+        // In case any weren't announced via the attach callback
         deviceCount = WacomMTGetAttachedDeviceIDs(deviceIDs, sizeof(deviceIDs));
 
         if (deviceCount > MAX_ATTACHED_DEVICES) {
@@ -53,155 +215,895 @@ bool Touch::init() {
         }
         else {
             for(int ii = 0; ii < deviceCount; ii++) {
-                WacomMTRegisterFingerReadCallback(
-                    deviceIDs[ii],          // deviceID
-                    nullptr,                // hitRect
-                    WMTProcessingModeNone,  // mode
-                    OnFinger,               // fingerCallback
-                    this                    // userData
-                );
+                WacomMTCapability capabilities = {};
+                WacomMTGetDeviceCapabilities(deviceIDs[ii], &capabilities);
+                this->_deviceAttached(capabilities);
             }
 
             wasInitialised = true;
         }
     }
+#endif
+
+    // Devices attached from here on grow their buffers as they go
+    _started.store(true, std::memory_order_release);
 
     return wasInitialised;
 }
 
 
+auto Touch::_device(int deviceId) -> Device* {
+    Device* unused = nullptr;
+
+    for (auto& device : _devices) {
+        if (device.used && device.deviceId == deviceId) return &device;
+        if (!device.used && !unused) unused = &device;
+    }
+
+    // First time we hear of it, e.g. replayed or not yet attached
+    if (unused) {
+        unused->deviceId = deviceId;
+        unused->used = true;
+        unused->attached = false;
+        unused->registered = false;
+        unused->clipped = false;
+        unused->capability = {};
+        unused->capability.DeviceID = deviceId;
+        unused->jitter.reset();
+        unused->seenFrame = false;
+        unused->fingers.clear();
+        unused->fingers.reserve(DEFAULT_FINGER_MAX);
+    }
+
+    return unused;
+}
+
+
+void Touch::_updateFingerMax() {
+    std::size_t fingerMax { 0 };
+
+    for (auto& device : _devices) {
+        if (device.attached) fingerMax += std::size_t(device.capability.FingerMax);
+    }
+
+    _fingerMax.store(std::max(fingerMax, std::size_t(DEFAULT_FINGER_MAX)), std::memory_order_relaxed);
+}
+
+
 void Touch::_deviceAttached(WacomMTCapability deviceInfo) {
+    WacomMTHitRect hitRect {};
+    bool clipped = false;
+    bool blobs = false;
+    bool raw = false;
+
+    {
+        std::lock_guard<std::mutex> lock { _mutex };
+        Device* device = this->_device(deviceInfo.DeviceID);
+
+        if (!device) {
+            std::cerr << "More tablets attached than there is room for, "
+                      << "ignoring device " << deviceInfo.DeviceID << "\n";
+            return;
+        }
+
+        device->capability = deviceInfo;
+        device->attached = true;
+        device->fingers.reserve(std::size_t(std::max(deviceInfo.FingerMax, DEFAULT_FINGER_MAX)));
+        this->_updateFingerMax();
+
+        // Already attached, e.g. announced both via callback and by `init()`
+        if (device->registered) return;
+        device->registered = true;
+
+        device->blobsRegistered = _blobsEnabled.load(std::memory_order_relaxed) &&
+                                  (deviceInfo.CapabilityFlags & WMTCapabilityFlagsBlobAvailable);
+        device->rawRegistered = _rawEnabled.load(std::memory_order_relaxed) &&
+                                (deviceInfo.CapabilityFlags & WMTCapabilityFlagsRawAvailable);
+
+        // Opaque tablets don't map onto the screen, so there's nothing to clip to
+        device->clipped = _hasHitRect && deviceInfo.Type == WMTDeviceTypeIntegrated;
+        device->hitRect = _hitRect;
+        hitRect = device->hitRect;
+        clipped = device->clipped;
+        blobs = device->blobsRegistered;
+        raw = device->rawRegistered;
+    }
+
+    // Before its callbacks are registered, such that no frame allocates
+    if (!_started.load(std::memory_order_acquire)) {
+        this->_reserveFrames(deviceInfo, blobs, raw);
+    }
+
+#ifdef _WIN32
+    // Outside of the lock, in case the SDK calls back from within
+    const WacomMTError err = WacomMTRegisterFingerReadCallback(
+        deviceInfo.DeviceID,            // deviceID
+        clipped ? &hitRect : nullptr,   // hitRect
+        WMTProcessingModeNone,          // mode
+        OnFinger,                       // fingerCallback
+        this                            // userData
+    );
+
+    if (err != WMTErrorSuccess) {
+        std::cerr << "Couldn't listen to device " << deviceInfo.DeviceID << ": " << err << "\n";
+
+        std::lock_guard<std::mutex> lock { _mutex };
+        if (Device* device = this->_device(deviceInfo.DeviceID)) device->registered = false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock { _mutex };
+        if (Device* device = this->_device(deviceInfo.DeviceID)) {
+            blobs = device->blobsRegistered;
+            raw = device->rawRegistered;
+        }
+    }
+
+    if (blobs && WacomMTRegisterBlobReadCallback(deviceInfo.DeviceID, clipped ? &hitRect : nullptr,
+                                                 WMTProcessingModeNone, OnBlob, this) != WMTErrorSuccess) {
+        std::cerr << "Couldn't listen to blobs of device " << deviceInfo.DeviceID << "\n";
+
+        std::lock_guard<std::mutex> lock { _mutex };
+        if (Device* device = this->_device(deviceInfo.DeviceID)) device->blobsRegistered = false;
+    }
+
+    if (raw && WacomMTRegisterRawReadCallback(deviceInfo.DeviceID, WMTProcessingModeNone,
+                                              OnRaw, this) != WMTErrorSuccess) {
+        std::cerr << "Couldn't listen to raw data of device " << deviceInfo.DeviceID << "\n";
+
+        std::lock_guard<std::mutex> lock { _mutex };
+        if (Device* device = this->_device(deviceInfo.DeviceID)) device->rawRegistered = false;
+    }
+#else
+    (void)hitRect;
+    (void)clipped;
+#endif
+}
+
+
+void Touch::_reserveFrames(const WacomMTCapability& capability, bool blobs, bool raw) {
+    const std::size_t blobMax = std::size_t(std::max(capability.BlobMax, 0));
+    const std::size_t pointMax = blobMax * std::size_t(std::max(capability.BlobPointsMax, 0));
+    const std::size_t elements = std::size_t(std::max(capability.ScanSizeX, 0)) *
+                                 std::size_t(std::max(capability.ScanSizeY, 0));
+
+    // The consumer isn't reading yet, but a device attached earlier may be
+    // filling its back buffer, so wait for it to finish
+    if (blobs) {
+        while (_blobsBusy.exchange(true, std::memory_order_acquire)) std::this_thread::yield();
+
+        _blobs.each([blobMax, pointMax](BlobFrame& frame) {
+            frame.blobs.reserve(blobMax);
+            frame.points.reserve(pointMax);
+        });
+
+        _blobsBusy.store(false, std::memory_order_release);
+    }
+
+    if (raw) {
+        while (_rawBusy.exchange(true, std::memory_order_acquire)) std::this_thread::yield();
+
+        _raw.each([elements](RawFrame& frame) {
+            frame.sensitivity.reserve(elements);
+        });
+
+        _rawBusy.store(false, std::memory_order_release);
+    }
 }
 
 
 void Touch::_deviceDetached(int deviceID) {
+    bool wasRegistered = false;
+    bool blobsWereRegistered = false;
+    bool rawWasRegistered = false;
+    bool wasClipped = false;
+    WacomMTHitRect hitRect {};
+    Samples lifted;
+
+    {
+        std::lock_guard<std::mutex> lock { _mutex };
+
+        for (auto& device : _devices) {
+            if (!device.used || device.deviceId != deviceID) continue;
+
+            // Lift any fingers still in contact, or they'd linger forever
+            TouchEvent event {};
+            event.deviceId = deviceID;
+            event.state = TouchState::Up;
+            event.timestamp = now();
+            event.confidence = true;
+            event.synthesised = true;
+
+            for (FingerId fingerId : device.fingers) {
+                event.fingerId = fingerId;
+                _queue.push(event);
+                lifted.push_back(event);
+            }
+
+            wasRegistered = device.registered;
+            blobsWereRegistered = device.blobsRegistered;
+            rawWasRegistered = device.rawRegistered;
+            wasClipped = device.clipped;
+            hitRect = device.hitRect;
+            device.used = false;
+            device.attached = false;
+            device.registered = false;
+            device.blobsRegistered = false;
+            device.rawRegistered = false;
+            device.fingers.clear();
+
+            Device* expected = &device;
+            _lastDevice.compare_exchange_strong(expected, nullptr);
+        }
+
+        this->_updateFingerMax();
+    }
+
+    for (const auto& event : lifted) this->touchUpEvent(event);
+
+#ifdef _WIN32
+    // With the rect it was registered with, or the SDK won't know which
+    if (wasRegistered) {
+        WacomMTUnRegisterFingerReadCallback(deviceID, wasClipped ? &hitRect : nullptr,
+                                            WMTProcessingModeNone, this);
+    }
+
+    if (blobsWereRegistered) {
+        WacomMTUnRegisterBlobReadCallback(deviceID, wasClipped ? &hitRect : nullptr,
+                                          WMTProcessingModeNone, this);
+    }
+
+    if (rawWasRegistered) {
+        WacomMTUnRegisterRawReadCallback(deviceID, WMTProcessingModeNone, this);
+    }
+#else
+    (void)wasRegistered;
+    (void)blobsWereRegistered;
+    (void)rawWasRegistered;
+    (void)wasClipped;
+#endif
 }
 
 
-void Touch::_fingerCallBack(WacomMTFingerCollection *fingerPacket) {
-    for(int fingerIndex = 0; fingerIndex < fingerPacket->FingerCount; fingerIndex++)
+void Touch::setHitRect(WacomMTHitRect rect) {
+    // Without locking, as most frames it's the same rect as last time
+    if (_hasRequestedHitRect && _requestedHitRect.originX == rect.originX &&
+        _requestedHitRect.originY == rect.originY && _requestedHitRect.width == rect.width &&
+        _requestedHitRect.height == rect.height) return;
+
+    _requestedHitRect = rect;
+    _hasRequestedHitRect = true;
+
+    struct Move {
+        int deviceId;
+        bool wasClipped;
+        bool blobs;
+        WacomMTHitRect from;
+    };
+
+    std::array<Move, MAX_ATTACHED_DEVICES> moves;
+    std::size_t count { 0 };
+
     {
-        WacomMTFinger* finger = &fingerPacket->Fingers[fingerIndex];
+        std::lock_guard<std::mutex> lock { _mutex };
 
-        TouchEvent event{};
-        event.fingerId     = finger->FingerID;
-        event.x            = finger->X;
-        event.y            = finger->Y;            
-        event.width        = finger->Width;
-        event.height       = finger->Height;
-        event.orientation  = finger->Orientation;
-        event.confidence   = finger->Confidence;
-        event.fingerCount  = fingerPacket->FingerCount;
+        _hitRect = rect;
+        _hasHitRect = true;
 
-        if (finger->TouchState == WMTFingerStateNone) {}
+        for (auto& device : _devices) {
+            if (!device.registered || device.capability.Type != WMTDeviceTypeIntegrated) continue;
 
-        else if (finger->TouchState == WMTFingerStateDown) {
-            event.state = TouchState::Down;
-            this->_touchDownEvent(event);
+            moves[count++] = { device.deviceId, device.clipped, device.blobsRegistered, device.hitRect };
+            device.clipped = true;
+            device.hitRect = rect;
         }
+    }
 
-        else if (finger->TouchState == WMTFingerStateHold) {
-            event.state = TouchState::Hold;
-            this->_touchHoldEvent(event);
+#ifdef _WIN32
+    // Outside of the lock, in case the SDK calls back from within
+    for (std::size_t ii = 0; ii < count; ii++) {
+        auto& move = moves[ii];
+        WacomMTError err;
+
+        if (move.wasClipped) {
+            err = WacomMTMoveRegisteredFingerReadCallback(move.deviceId, &move.from, WMTProcessingModeNone,
+                                                          &rect, this);
+        }
+        else {
+            // Registered before there was a rect, so there's nothing to move from
+            WacomMTUnRegisterFingerReadCallback(move.deviceId, nullptr, WMTProcessingModeNone, this);
+            err = WacomMTRegisterFingerReadCallback(move.deviceId, &rect, WMTProcessingModeNone,
+                                                    OnFinger, this);
         }
 
-        else if (finger->TouchState == WMTFingerStateUp) {
-            event.state = TouchState::Up;
-            this->_touchUpEvent(event);
+        if (err != WMTErrorSuccess) {
+            std::cerr << "Couldn't move hit rect of device " << move.deviceId << ": " << err << "\n";
         }
 
+        if (!move.blobs) continue;
+
+        if (move.wasClipped) {
+            err = WacomMTMoveRegisteredBlobReadCallback(move.deviceId, &move.from, WMTProcessingModeNone,
+                                                        &rect, this);
+        }
         else {
-            std::cerr << "Warning: Unrecognised touch state: " << finger->TouchState << std::endl;
+            WacomMTUnRegisterBlobReadCallback(move.deviceId, nullptr, WMTProcessingModeNone, this);
+            err = WacomMTRegisterBlobReadCallback(move.deviceId, &rect, WMTProcessingModeNone,
+                                                  OnBlob, this);
+        }
+
+        if (err != WMTErrorSuccess) {
+            std::cerr << "Couldn't move blob hit rect of device " << move.deviceId << ": " << err << "\n";
         }
     }
+#else
+    (void)count;
+#endif
+}
+
+
+void Touch::_blobCallBack(WacomMTBlobAggregate *blobPacket) {
+    const Timestamp timestamp = now();
+    WacomMTCapability capability {};
+    bool attached = false;
+
+    {
+        std::lock_guard<std::mutex> lock { _mutex };
+        if (const Device* device = this->_device(blobPacket->DeviceID)) {
+            capability = device->capability;
+            attached = device->attached;
+        }
+    }
+
+    // Another device's frame is being copied, and we never wait
+    if (_blobsBusy.exchange(true, std::memory_order_acquire)) return;
+
+    // Owned by this thread until published
+    BlobFrame& frame = _blobs.back();
+    frame.deviceId = blobPacket->DeviceID;
+    frame.frameNumber = blobPacket->FrameNumber;
+    frame.timestamp = timestamp;
+    frame.blobs.clear();
+    frame.points.clear();
+
+    // Sized up front, see `_reserveFrames()`
+    if (attached) {
+        frame.originX = capability.LogicalOriginX;
+        frame.originY = capability.LogicalOriginY;
+        frame.width = capability.LogicalWidth;
+        frame.height = capability.LogicalHeight;
+    }
+
+    for (int blobIndex = 0; blobIndex < blobPacket->BlobCount; blobIndex++) {
+        const WacomMTBlob& blob = blobPacket->BlobArray[blobIndex];
+
+        Blob out;
+        out.blobId      = blob.BlobID;
+        out.x           = blob.X;
+        out.y           = blob.Y;
+        out.confidence  = blob.Confidence;
+        out.type        = blob.BlobType;
+        out.parentId    = blob.ParentID;
+        out.first       = frame.points.size();
+        out.count       = std::size_t(blob.PointCount);
+
+        frame.blobs.push_back(out);
+        frame.points.insert(frame.points.end(), blob.BlobPoints, blob.BlobPoints + blob.PointCount);
+    }
+
+    _blobs.publish();
+    _blobsBusy.store(false, std::memory_order_release);
+}
+
+
+void Touch::_rawCallBack(WacomMTRawData *rawPacket) {
+    const Timestamp timestamp = now();
+    int width = rawPacket->ElementCount;
+    int height = 1;
+
+    {
+        std::lock_guard<std::mutex> lock { _mutex };
+        const Device* device = this->_device(rawPacket->DeviceID);
+
+        if (device && device->attached &&
+            device->capability.ScanSizeX * device->capability.ScanSizeY == rawPacket->ElementCount) {
+            width = device->capability.ScanSizeX;
+            height = device->capability.ScanSizeY;
+        }
+    }
+
+    // Another device's frame is being copied, and we never wait
+    if (_rawBusy.exchange(true, std::memory_order_acquire)) {
+        _rawContended.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Owned by this thread until published
+    RawFrame& frame = _raw.back();
+    frame.deviceId = rawPacket->DeviceID;
+    frame.frameNumber = rawPacket->FrameNumber;
+    frame.timestamp = timestamp;
+    frame.width = width;
+    frame.height = height;
+
+    // Within capacity unless attached after `init()`, the SDK keeps ownership of its own
+    frame.sensitivity.resize(std::size_t(rawPacket->ElementCount));
+    std::copy(rawPacket->Sensitivity, rawPacket->Sensitivity + rawPacket->ElementCount,
+              frame.sensitivity.begin());
+
+    _raw.publish();
+    _rawBusy.store(false, std::memory_order_release);
+}
+
+
+auto Touch::rawFrame() -> const RawFrame& {
+    _raw.acquire();
+    return _raw.front();
+}
+
+
+auto Touch::blobs() -> const BlobFrame& {
+    _blobs.acquire();
+    return _blobs.front();
+}
+
+
+auto Touch::devices() const -> std::vector<WacomMTCapability> {
+    std::lock_guard<std::mutex> lock { _mutex };
+    std::vector<WacomMTCapability> devices;
+
+    for (auto& device : _devices) {
+        if (device.attached) devices.push_back(device.capability);
+    }
+
+    return devices;
+}
+
+
+auto Touch::framePeriod() const -> Timestamp {
+    const Device* device = _lastDevice.load(std::memory_order_acquire);
+    return device ? device->jitter.period() : 0;
+}
+
+
+auto Touch::jitter() const -> Timestamp {
+    const Device* device = _lastDevice.load(std::memory_order_acquire);
+    return device ? device->jitter.jitter() : 0;
+}
+
+
+void Touch::_fingerCallBack(WacomMTFingerCollection *fingerPacket) {
+    // Queued events, for the virtual callbacks once the lock is released;
+    // one per thread calling back, allocated once
+    static thread_local Samples delivered;
+    delivered.clear();
+
+    {
+        std::lock_guard<std::mutex> lock { _mutex };
+
+        // Under the lock, such that the queue is in timestamp order across devices
+        const Timestamp timestamp = now();
+
+        Device* device = this->_device(fingerPacket->DeviceID);
+        Timestamp jitter { 0 };
+
+        if (device) {
+            jitter = device->jitter.update(fingerPacket->FrameNumber, timestamp);
+            _lastDevice.store(device, std::memory_order_release);
+
+            // Packets only stop while nothing touches, any other gap is a loss
+            const int missed = fingerPacket->FrameNumber - device->lastFrame - 1;
+            if (device->seenFrame && !device->fingers.empty() && missed > 0) {
+                _frameGaps.fetch_add(1, std::memory_order_relaxed);
+                _framesMissed.fetch_add(std::size_t(missed), std::memory_order_relaxed);
+            }
+
+            device->lastFrame = fingerPacket->FrameNumber;
+            device->seenFrame = true;
+        }
+
+        if (auto* recorder = _recorder.load(std::memory_order_acquire)) {
+            recorder->record(*fingerPacket, timestamp);
+        }
+
+        const auto queue = [this](const TouchEvent& event) {
+            _queue.push(event);
+            delivered.push_back(event);
+        };
+
+        for(int fingerIndex = 0; fingerIndex < fingerPacket->FingerCount; fingerIndex++)
+        {
+            WacomMTFinger* finger = &fingerPacket->Fingers[fingerIndex];
+
+            TouchEvent event{};
+            event.fingerId     = finger->FingerID;
+            event.x            = finger->X;
+            event.y            = finger->Y;            
+            event.width        = finger->Width;
+            event.height       = finger->Height;
+            event.orientation  = finger->Orientation;
+            event.confidence   = finger->Confidence;
+            event.sensitivity  = finger->Sensitivity;
+            event.fingerCount  = fingerPacket->FingerCount;
+            event.deviceId     = fingerPacket->DeviceID;
+            event.frameNumber  = fingerPacket->FrameNumber;
+            event.timestamp    = timestamp;
+            event.jitter       = jitter;
+
+            const bool known = !device || std::find(device->fingers.begin(), device->fingers.end(),
+                                                    event.fingerId) != device->fingers.end();
+
+            // Bookkeeping happens on the polling thread, see `_drain()`
+            if (finger->TouchState == WMTFingerStateNone) {}
+
+            else if (finger->TouchState == WMTFingerStateDown) {
+                event.state = TouchState::Down;
+                queue(event);
+
+                if (device && std::find(device->fingers.begin(), device->fingers.end(),
+                                        event.fingerId) == device->fingers.end()) {
+                    device->fingers.push_back(event.fingerId);
+                }
+            }
+
+            else if (finger->TouchState == WMTFingerStateHold) {
+                // E.g. the Down packet was lost
+                if (!known) {
+                    _holdsWithoutDown.fetch_add(1, std::memory_order_relaxed);
+
+                    event.state = TouchState::Down;
+                    event.synthesised = true;
+                    queue(event);
+                    device->fingers.push_back(event.fingerId);
+                }
+
+                event.state = TouchState::Hold;
+                event.synthesised = false;
+                queue(event);
+            }
+
+            // Nothing to lift
+            else if (finger->TouchState == WMTFingerStateUp && !known) {
+                _upsWithoutDown.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            else if (finger->TouchState == WMTFingerStateUp) {
+                event.state = TouchState::Up;
+                queue(event);
+
+                if (device) {
+                    device->fingers.erase(std::remove(device->fingers.begin(), device->fingers.end(),
+                                                      event.fingerId), device->fingers.end());
+                }
+            }
+
+            else {
+                std::cerr << "Warning: Unrecognised touch state: " << finger->TouchState << std::endl;
+            }
+        }
+
+        // Every packet lists every finger in contact, so any not listed
+        // has lifted, and its Up packet was lost
+        for (std::size_t ii = 0; device && ii < device->fingers.size();) {
+            const FingerId fingerId = device->fingers[ii];
+            bool listed = false;
+
+            for (int fingerIndex = 0; fingerIndex < fingerPacket->FingerCount; fingerIndex++) {
+                if (fingerPacket->Fingers[fingerIndex].FingerID == fingerId) listed = true;
+            }
+
+            if (listed) {
+                ii++;
+                continue;
+            }
+
+            _unliftedFingers.fetch_add(1, std::memory_order_relaxed);
+
+            TouchEvent event {};
+            event.fingerId = fingerId;
+            event.fingerCount = fingerPacket->FingerCount;
+            event.deviceId = fingerPacket->DeviceID;
+            event.frameNumber = fingerPacket->FrameNumber;
+            event.timestamp = timestamp;
+            event.jitter = jitter;
+            event.confidence = true;
+            event.state = TouchState::Up;
+            event.synthesised = true;
+
+            queue(event);
+            device->fingers.erase(device->fingers.begin() + ii);
+        }
+    }
+
+    for (const auto& event : delivered) {
+             if (event.state == TouchState::Down) this->touchDownEvent(event);
+        else if (event.state == TouchState::Hold) this->touchHoldEvent(event);
+        else if (event.state == TouchState::Up)   this->touchUpEvent(event);
+    }
 }
 
 
 void Touch::printAttachedDevices() const {
-    int deviceIDs[MAX_ATTACHED_DEVICES] = {};
-    int deviceCount = 0;
+    // Capabilities are queried once on attach, rather than here
+    for (const auto& capabilities : this->devices()) {
+        const auto type = capabilities.Type == WMTDeviceTypeIntegrated ? "Integrated"
+                        : capabilities.Type == WMTDeviceTypeOpaque ? "Opaque"
+                        : "Unknown";
+
+        std::cout << "Version: "        << capabilities.Version         << std::endl
+                  << "DeviceID: "       << capabilities.DeviceID        << std::endl
+                  << "Type: "           << type                         << std::endl
+                  << "LogicalOriginX: " << capabilities.LogicalOriginX  << std::endl
+                  << "LogicalOriginY: " << capabilities.LogicalOriginY  << std::endl
+                  << "LogicalWidth: "   << capabilities.LogicalWidth    << std::endl
+                  << "LogicalHeight: "  << capabilities.LogicalHeight   << std::endl
+                  << "PhysicalSizeX: "  << capabilities.PhysicalSizeX   << std::endl
+                  << "PhysicalSizeY: "  << capabilities.PhysicalSizeY   << std::endl
+                  << "ReportedSizeX: "  << capabilities.ReportedSizeX   << std::endl
+                  << "ReportedSizeY: "  << capabilities.ReportedSizeY   << std::endl
+                  << "FingerMax: "      << capabilities.FingerMax       << std::endl;
+    }
+}
 
-    // Ask the Wacom API for all connected touch API-capable devices.
-    // Pass a comfortably large buffer so you don't have to call this method twice.
-    deviceCount = WacomMTGetAttachedDeviceIDs(deviceIDs, sizeof(deviceIDs));
 
-    if (deviceCount > MAX_ATTACHED_DEVICES) {
-        std::cerr << "More tablets connected than would fit in the "
-                  << "supplied buffer. Will need to reallocate buffer!";
+void Touch::_drain() {
+    TouchEvent event;
+    _samples.clear();
+    _events.reserve(this->fingerMax());
+
+    const Timestamp drained = now();
+    Timestamp latencyMax = _latencyMax.load(std::memory_order_relaxed);
+    Timestamp latencySum { 0 };
+    std::size_t measured { 0 };
+    std::size_t popped { 0 };
+    std::size_t coalesced { 0 };
+
+    // Bounded by capacity, such that `_samples` never reallocates
+    // and a busy producer can't keep us here indefinitely
+    while (popped < _samples.capacity() && _queue.pop(event)) {
+        popped++;
+
+        if (event.state == TouchState::Hold && this->_redundant(event)) {
+            coalesced++;
+            continue;
+        }
+
+        // Pushed while draining, after `drained` was taken
+        const Timestamp latency = std::max(drained - event.timestamp, Timestamp(0));
+        latencySum += latency;
+        if (latency > latencyMax) latencyMax = latency;
+        _pollLatency.record(latency);
+        measured++;
+
+        const TouchEvent* known = _events.find(event.deviceId, event.fingerId);
+
+        // Its Down was lost on the way, e.g. to a full queue
+        if (event.state == TouchState::Hold && !known) {
+            _downsLost.fetch_add(1, std::memory_order_relaxed);
+
+            TouchEvent down = event;
+            down.state = TouchState::Down;
+            down.synthesised = true;
+            this->_consume(down);
+        }
+
+        // Made up by the producer, which doesn't keep track of where fingers are
+        if (event.synthesised && event.state == TouchState::Up && known) {
+            event.x = known->x;
+            event.y = known->y;
+            event.width = known->width;
+            event.height = known->height;
+            event.orientation = known->orientation;
+            event.sensitivity = known->sensitivity;
+        }
+
+        this->_consume(event);
+    }
+
+    _latencySum.fetch_add(latencySum, std::memory_order_relaxed);
+    _latencyCount.fetch_add(measured, std::memory_order_relaxed);
+    _latencyMax.store(latencyMax, std::memory_order_relaxed);
+    _coalesced.fetch_add(coalesced, std::memory_order_relaxed);
+    _polled = drained;
+
+    this->_liftStale(drained);
+}
+
+
+void Touch::_consume(const TouchEvent& event) {
+    // Room was made for every sample popped, not for those made up
+    if (_samples.size() < _samples.capacity()) _samples.push_back(event);
+
+    // Drawn on the next `drawn()`, unless more pile up than would fit
+    if (event.state == TouchState::Down && _undrawn.size() < _undrawn.capacity()) {
+        _undrawn.push_back(event.timestamp);
     }
-    else {       
-        for(int ii = 0; ii < deviceCount; ii++) {
-            int deviceID = deviceIDs[ii];
 
-            WacomMTCapability capabilities = {};
-            WacomMTGetDeviceCapabilities(deviceID, &capabilities);
+         if (event.state == TouchState::Down) this->_touchDownEvent(event);
+    else if (event.state == TouchState::Hold) this->_touchHoldEvent(event);
+    else if (event.state == TouchState::Up)   this->_touchUpEvent(event);
+}
+
+
+void Touch::drawn(Timestamp at) {
+    if (_polled) _drawLatency.record(at - _polled);
+    _polled = 0;
+
+    for (Timestamp down : _undrawn) _touchDownLatency.record(at - down);
+    _undrawn.clear();
+}
+
+
+void Touch::resetHistograms() {
+    _pollLatency.reset();
+    _drawLatency.reset();
+    _touchDownLatency.reset();
+    _touchDuration.reset();
+}
+
+
+void Touch::_liftStale(Timestamp drained) {
+    // Resting fingers are still sampled at least this often, see `setCoalescing()`
+    const Timestamp timeout = std::max(Timestamp(DEFAULT_LIFT_TIMEOUT), 2 * _coalesceMaxIdle);
+
+    // E.g. its Up was lost to a full queue, or the device went quiet
+    for (const auto& event : _events) {
+        if (event.state == TouchState::Up || drained - event.timestamp < timeout) continue;
 
-            const auto type = capabilities.Type == WMTDeviceTypeIntegrated ? "Integrated"
-                            : capabilities.Type == WMTDeviceTypeOpaque ? "Opaque"
-                            : "Unknown";
+        _upsLost.fetch_add(1, std::memory_order_relaxed);
 
-            std::cout << "Version: "        << capabilities.Version         << std::endl
-                      << "DeviceID: "       << capabilities.DeviceID        << std::endl
-                      << "Type: "           << type                         << std::endl
-                      << "LogicalOriginX: " << capabilities.LogicalOriginX  << std::endl
-                      << "LogicalOriginY: " << capabilities.LogicalOriginY  << std::endl
-                      << "LogicalWidth: "   << capabilities.LogicalWidth    << std::endl
-                      << "LogicalHeight: "  << capabilities.LogicalHeight   << std::endl
-                      << "PhysicalSizeX: "  << capabilities.PhysicalSizeX   << std::endl
-                      << "PhysicalSizeY: "  << capabilities.PhysicalSizeY   << std::endl
-                      << "ReportedSizeX: "  << capabilities.ReportedSizeX   << std::endl
-                      << "ReportedSizeY: "  << capabilities.ReportedSizeY   << std::endl;
+        TouchEvent up = event;
+        up.state = TouchState::Up;
+        up.synthesised = true;
+        this->_consume(up);
+
+        // The producer still has it down, should it be sampled again it goes Down anew
+        std::lock_guard<std::mutex> lock { _mutex };
+        for (auto& device : _devices) {
+            if (!device.used || device.deviceId != up.deviceId) continue;
+
+            device.fingers.erase(std::remove(device.fingers.begin(), device.fingers.end(), up.fingerId),
+                                 device.fingers.end());
         }
     }
 }
 
 
+auto Touch::integrity() const -> Integrity {
+    Integrity integrity;
+    integrity.frameGaps = _frameGaps.load(std::memory_order_relaxed);
+    integrity.framesMissed = _framesMissed.load(std::memory_order_relaxed);
+    integrity.holdsWithoutDown = _holdsWithoutDown.load(std::memory_order_relaxed);
+    integrity.upsWithoutDown = _upsWithoutDown.load(std::memory_order_relaxed);
+    integrity.unliftedFingers = _unliftedFingers.load(std::memory_order_relaxed);
+    integrity.downsLost = _downsLost.load(std::memory_order_relaxed);
+    integrity.upsLost = _upsLost.load(std::memory_order_relaxed);
+    return integrity;
+}
+
+
+bool Touch::_redundant(const TouchEvent& event) const {
+    const TouchEvent* last = _events.find(event.deviceId, event.fingerId);
+
+    // Nothing to compare against, leave it to `_touchHoldEvent()`
+    if (!last) return false;
+
+    return std::abs(event.x - last->x) <= _coalesceEpsilon &&
+           std::abs(event.y - last->y) <= _coalesceEpsilon &&
+           event.width == last->width &&
+           event.height == last->height &&
+           event.timestamp - last->timestamp < _coalesceMaxIdle;
+}
+
+
+auto Touch::meanLatency() const -> Timestamp {
+    const auto count = _latencyCount.load(std::memory_order_relaxed);
+    return count ? _latencySum.load(std::memory_order_relaxed) / Timestamp(count) : 0;
+}
+
+
 void Touch::_touchDownEvent(TouchEvent event) {
-    _events[event.fingerId] = event;
-    this->touchDownEvent(event);
+    if (auto* finger = _events.find(event.deviceId, event.fingerId)) *finger = event;
+    else _events.insert(event);
+
+    // Replacing the same finger, or else the oldest, e.g. one whose Up was lost
+    auto down = std::find_if(_downs.begin(), _downs.end(), [&](const Down& down) {
+        return down.deviceId == event.deviceId && down.fingerId == event.fingerId;
+    });
+
+    if (down == _downs.end() && _downs.size() < _downs.capacity()) {
+        _downs.push_back({ event.deviceId, event.fingerId, event.timestamp });
+        return;
+    }
+
+    if (down == _downs.end()) {
+        down = std::min_element(_downs.begin(), _downs.end(), [](const Down& a, const Down& b) {
+            return a.timestamp < b.timestamp;
+        });
+    }
+
+    *down = { event.deviceId, event.fingerId, event.timestamp };
 }
 
 
 void Touch::_touchHoldEvent(TouchEvent event) {
-    auto& finger = _events.at(event.fingerId);
+    // A Down is synthesised ahead of any Hold without one, see `_drain()`
+    auto* finger = _events.find(event.deviceId, event.fingerId);
+    if (!finger) return;
 
-    if (finger.state == TouchState::Hold) {
-        finger.x = event.x;
-        finger.y = event.y;
-        finger.width = event.width;
-        finger.height = event.height;
+    if (finger->state == TouchState::Hold) {
+        finger->x = event.x;
+        finger->y = event.y;
+        finger->width = event.width;
+        finger->height = event.height;
+        finger->frameNumber = event.frameNumber;
+        finger->timestamp = event.timestamp;
+        finger->jitter = event.jitter;
     }
-
-    this->touchHoldEvent(event);
 }
 
 
 void Touch::_touchUpEvent(TouchEvent event) {
+    for (std::size_t ii = 0; ii < _downs.size(); ii++) {
+        if (_downs[ii].deviceId != event.deviceId || _downs[ii].fingerId != event.fingerId) continue;
+
+        _touchDuration.record(event.timestamp - _downs[ii].timestamp);
+        _downs[ii] = _downs.back();
+        _downs.pop_back();
+        break;
+    }
+
     // Can happen on low-confidence events
-    if (!_events.count(event.fingerId)) return;
+    if (!_events.count(event.deviceId, event.fingerId)) return;
 
-    auto& finger = _events.at(event.fingerId);
+    auto& finger = *_events.find(event.deviceId, event.fingerId);
     finger.state = TouchState::Up;
-    this->touchUpEvent(event);
 }
 
 
 auto Touch::poll() -> const PollEvents {
-    PollEvents events = _events;
+    this->_drain();
+
+    PollEvents events;
+    for (auto& event : _events) events[event.fingerId] = event;
+
+    this->_advance();
+    return events;
+}
+
+
+void Touch::poll(Contacts& contacts) {
+    // Only ever grows when a device is attached
+    contacts.reserve(this->fingerMax());
+
+    this->_drain();
+
+    contacts.clear();
+    for (auto& event : _events) {
+        if (!contacts.insert(event)) break;
+    }
+
+    this->_advance();
+}
+
+
+void Touch::_advance() {
+    for (std::size_t ii = 0; ii < _events.size();) {
+        auto& event = *(_events.begin() + ii);
 
-    for (auto [fingerId, event] : events) {
         if (event.state == TouchState::Up) {
-            _events.erase(fingerId);
+            _events.erase(event.deviceId, event.fingerId);
+            continue;
         }
 
         // Stick keys
         // Don't actually permit Hold events until Down has been polled
         if (event.state == TouchState::Down) {
-            _events.at(fingerId).state = TouchState::Hold;
+            event.state = TouchState::Hold;
         }
-    }
 
-    return events;
+        ii++;
+    }
 }
 
 
@@ -1,17 +1,53 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
-#include <SDKDDKVer.h>
-#include <windows.h>
+#include <vector>
 
-#include <WacomMultiTouch.h>
+// Types only, such that this builds without windows.h or the SDK
+#include <WacomMultiTouchTypes.h>
+
+#include "Blobs.h"
+#include "Histogram.h"
+#include "RawFrame.h"
+#include "RingBuffer.h"
+#include "TouchSource.h"
+#include "TripleBuffer.h"
 
 #define MAX_ATTACHED_DEVICES 10
+#define DEFAULT_QUEUE_CAPACITY 1024
+
+// Used until a device reports its own `FingerMax`
+#define DEFAULT_FINGER_MAX 16
+
+// Hold samples closer than this to the last one of a finger are dropped,
+// unless that was longer ago than the max idle time, in nanoseconds
+#define DEFAULT_COALESCE_EPSILON 0.0f
+#define DEFAULT_COALESCE_MAX_IDLE 100'000'000
+
+// Contacts without a sample for this long are lifted, in nanoseconds
+#define DEFAULT_LIFT_TIMEOUT 1'000'000'000
 
 namespace Wacom {
 
+class Recorder;
+
 using FingerId = int;
 
+// Nanoseconds since an arbitrary, but monotonic, epoch
+using Timestamp = std::int64_t;
+
+inline auto now() -> Timestamp {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
 enum class TouchState {
     None = 0, Up, Down, Hold
 };
@@ -20,6 +56,17 @@ struct TouchEvent {
     FingerId fingerId;
     int fingerCount;
 
+    // As reported by the `WacomMTFingerCollection` this came from
+    int deviceId;
+    int frameNumber;
+
+    // When the packet reached `_fingerCallBack`
+    Timestamp timestamp;
+
+    // How much later (or earlier, if negative) the packet arrived
+    // than expected given its `frameNumber`, in nanoseconds
+    Timestamp jitter;
+
     // Whether or not this can be considered a finger,
     // or erroneous input such as your palm or elbow
     bool confidence;
@@ -39,35 +86,384 @@ struct TouchEvent {
     float orientation;
 
     unsigned short sensitivity;
+
+    // Made up in place of a packet that was lost, e.g. the Up of a finger
+    // that went missing, with the position and size of its last sample
+    bool synthesised;
 };
 
 // Keep track of last spotted events, for `poll()`
 using PollEvents = std::unordered_map<int, TouchEvent>;
 
 
-class Touch {
+// Estimate the sensor's frame period from `FrameNumber` deltas
+//
+// The SDK doesn't timestamp packets, so this is based on when they
+// arrive. Call `update()` from one thread, read from any.
+class JitterEstimator {
 public:
-    bool init();
-    void printAttachedDevices() const;
+    // Returns the arrival jitter of this packet
+    auto update(int frameNumber, Timestamp arrival) -> Timestamp;
+    void reset();
+
+    // Smoothed estimates, in nanoseconds
+    auto period() const -> Timestamp { return _period.load(std::memory_order_relaxed); }
+    auto jitter() const -> Timestamp { return _jitter.load(std::memory_order_relaxed); }
+
+private:
+    int _lastFrame { 0 };
+    Timestamp _lastArrival { 0 };
+
+    std::atomic<Timestamp> _period { 0 };
+    std::atomic<Timestamp> _jitter { 0 };
+};
+
+
+// Every sample, in the order received
+using Samples = std::vector<TouchEvent>;
+
+
+// Inconsistencies spotted in the stream of packets, see `Touch::integrity()`
+struct Integrity {
+    // Packets arriving more than one frame after the last of their device,
+    // while it was being touched, and how many frames went missing in total
+    std::size_t frameGaps;
+    std::size_t framesMissed;
+
+    // Hold of a finger that never went Down according to its device's
+    // packets, a Down is synthesised as it arrives
+    std::size_t holdsWithoutDown;
+
+    // Up of a finger that never went Down, dropped
+    std::size_t upsWithoutDown;
+
+    // Fingers that went missing from their device's packets without
+    // an Up, an Up is synthesised as the next packet arrives
+    std::size_t unliftedFingers;
+
+    // Hold without a Down by the time it was polled, e.g. as the Down
+    // was lost to a full queue, a Down is synthesised
+    std::size_t downsLost;
+
+    // Fingers without samples for `DEFAULT_LIFT_TIMEOUT`, e.g. as their Up
+    // was lost to a full queue, an Up is synthesised. Should the finger be
+    // sampled again after all, it goes Down anew, see `holdsWithoutDown`.
+    std::size_t upsLost;
+};
+
+
+// Fixed-capacity table of active contacts, for `poll(Contacts&)`
+//
+// Contacts are keyed by device and finger ID, and remapped to dense
+// slots such that iteration only ever visits live contacts in contiguous
+// memory. Memory is allocated on construction and `reserve()` only;
+// inserting beyond `capacity()` is refused.
+class Contacts {
+public:
+    explicit Contacts(std::size_t capacity = DEFAULT_FINGER_MAX);
+
+    Contacts(Contacts&&) = default;
+    Contacts& operator=(Contacts&&) = default;
+
+    auto begin() const -> const TouchEvent* { return _slots.get(); }
+    auto end() const -> const TouchEvent* { return _slots.get() + _size; }
+    auto begin() -> TouchEvent* { return _slots.get(); }
+    auto end() -> TouchEvent* { return _slots.get() + _size; }
+
+    auto size() const -> std::size_t { return _size; }
+    auto capacity() const -> std::size_t { return _capacity; }
+    bool empty() const { return _size == 0; }
+
+    // Returns nullptr if `fingerId` isn't currently in contact
+    auto find(int deviceId, FingerId fingerId) -> TouchEvent*;
+    auto find(int deviceId, FingerId fingerId) const -> const TouchEvent*;
+    bool count(int deviceId, FingerId fingerId) const { return find(deviceId, fingerId) != nullptr; }
+
+    // Of any device, for when there's only the one
+    auto find(FingerId fingerId) -> TouchEvent*;
+    auto find(FingerId fingerId) const -> const TouchEvent*;
+    bool count(FingerId fingerId) const { return find(fingerId) != nullptr; }
+
+    // Throws std::out_of_range, like `PollEvents::at()`
+    auto at(FingerId fingerId) -> TouchEvent&;
+    auto at(FingerId fingerId) const -> const TouchEvent&;
+
+    // Returns nullptr if the table is full
+    auto insert(const TouchEvent& event) -> TouchEvent*;
+
+    // Moves the last slot into the hole, so slot order isn't stable
+    void erase(int deviceId, FingerId fingerId);
+    void clear() { _size = 0; }
+
+    // Grow, keeping current contacts. Allocates
+    void reserve(std::size_t capacity);
+
+private:
+    std::unique_ptr<TouchEvent[]> _slots;
+    std::size_t _size { 0 };
+    std::size_t _capacity { 0 };
+};
+
+
+// Finger input via the Wacom Feel SDK
+//
+// Subclass and override `init()` to feed packets from elsewhere,
+// see e.g. `Replay`.
+class Touch : public TouchSource {
+public:
+    // Capacity of the queue between the Wacom callback thread
+    // and `poll()`, in number of finger samples.
+    explicit Touch(std::size_t queueCapacity = DEFAULT_QUEUE_CAPACITY);
+
+    bool init() override;
+    void printAttachedDevices() const override;
 
     // Either poll for events..
+    //
+    // Keyed by finger ID alone, so with more than one device
+    // attached, prefer `poll(Contacts&)`
     auto poll() -> const PollEvents;
 
+    // ..or poll into a caller-owned table, without allocating
+    //
+    // The table is only grown when a device with more fingers
+    // is attached, see `fingerMax()`.
+    void poll(Contacts& contacts);
+
+    // Every sample consumed by the last `poll()`, including intermediate
+    // Hold samples that `poll()` itself only reports the latest of.
+    // Storage is reused between calls.
+    auto samples() const -> const Samples& { return _samples; }
+
+    // Also listen for blobs, on devices that support them
+    //
+    // Call before `init()`, or it only applies to devices attached later.
+    void setBlobsEnabled(bool enabled) { _blobsEnabled = enabled; }
+
+    // The newest complete blob frame, call from the thread calling `poll()`
+    auto blobs() -> const BlobFrame&;
+
+    // Also listen for raw sensor frames, on devices that support them
+    //
+    // Call before `init()`, or it only applies to devices attached later.
+    void setRawEnabled(bool enabled) { _rawEnabled = enabled; }
+
+    // The newest complete raw frame, call from the thread calling `poll()`
+    //
+    // Never copied; valid until the next call. Empty until the first frame.
+    // Buffers are sized for devices attached by `init()`, those attached
+    // later may allocate on their first few frames.
+    auto rawFrame() -> const RawFrame&;
+
+    // Raw frames replaced by a newer one before `rawFrame()` got to them
+    auto rawFramesSkipped() const -> std::size_t {
+        return _raw.skipped() + _rawContended.load(std::memory_order_relaxed);
+    }
+
     // ..or attach a callback (or both)
     //
     // Depending on your polling rate, these may be more frequent
-    // and carry less duplicate data.
+    // and carry less duplicate data. Note that these are called
+    // from the Wacom callback thread, not the thread calling `poll()`.
     virtual void touchDownEvent(TouchEvent event) {}
     virtual void touchUpEvent(TouchEvent event) {}
     virtual void touchHoldEvent(TouchEvent event) {}
 
     // Internal callbacks for Wacom
+    //
+    // These may be called from any thread, at any time. Virtual callbacks
+    // are called from the same thread, once the packet is queued.
     void _deviceAttached(WacomMTCapability deviceInfo);
     void _deviceDetached(int deviceID);
     void _fingerCallBack(WacomMTFingerCollection *fingerPacket);
+    void _blobCallBack(WacomMTBlobAggregate *blobPacket);
+    void _rawCallBack(WacomMTRawData *rawPacket);
+
+    // Drop Hold samples that don't move a finger, e.g. while it rests
+    //
+    // Samples within `epsilon` of the last one kept, normalised like `x` and
+    // with the same size, are dropped; at least one every `maxIdle` is kept.
+    // State transitions are always kept. Call from the thread calling `poll()`.
+    void setCoalescing(float epsilon, Timestamp maxIdle) { _coalesceEpsilon = epsilon; _coalesceMaxIdle = maxIdle; }
+    auto coalesceEpsilon() const -> float { return _coalesceEpsilon; }
+    auto coalesceMaxIdle() const -> Timestamp { return _coalesceMaxIdle; }
+
+    // Samples dropped as redundant, see `setCoalescing()`
+    auto coalescedEvents() const -> std::size_t { return _coalesced.load(std::memory_order_relaxed); }
+
+    // Packets that didn't add up, and were patched up such that every
+    // Down is followed by an Up, and there's never a Hold or Up without a Down
+    auto integrity() const -> Integrity;
+
+    // Samples lost to a full queue, e.g. when `poll()` isn't called often enough
+    auto droppedEvents() const -> std::size_t { return _queue.overflowCount(); }
+    auto queueCapacity() const -> std::size_t { return _queue.capacity(); }
+
+    // Samples waiting for `poll()`, approximate unless called from either end
+    auto queueSize() const -> std::size_t { return _queue.size(); }
+
+    // Time from `_fingerCallBack` to `poll()`, in nanoseconds
+    auto meanLatency() const -> Timestamp;
+    auto maxLatency() const -> Timestamp { return _latencyMax.load(std::memory_order_relaxed); }
+
+    // Call once the frame showing the last `poll()` is on its way to
+    // the screen, e.g. after `swapBuffers()`, for `drawLatency()`
+    // and `touchDownLatency()`
+    void drawn(Timestamp at = now());
+
+    // Distributions of, in nanoseconds..
+    //
+    // ..time from `_fingerCallBack` to `poll()`, of every sample
+    auto pollLatency() const -> const Histogram& { return _pollLatency; }
+
+    // ..time from `poll()` to `drawn()`
+    auto drawLatency() const -> const Histogram& { return _drawLatency; }
+
+    // ..time from the `_fingerCallBack` of a Down to the first `drawn()` after it
+    auto touchDownLatency() const -> const Histogram& { return _touchDownLatency; }
+
+    // ..time from Down to Up, as seen by `poll()`
+    auto touchDuration() const -> const Histogram& { return _touchDuration; }
+
+    void resetHistograms();
+
+    // Write every packet to disk as it arrives, pass nullptr to stop
+    //
+    // The recorder must outlive this, or be detached first.
+    void setRecorder(Recorder* recorder) { _recorder.store(recorder, std::memory_order_release); }
+
+    // Sensor frame period and mean absolute arrival jitter, in nanoseconds,
+    // of whichever device most recently delivered a packet
+    auto framePeriod() const -> Timestamp;
+    auto jitter() const -> Timestamp;
+
+    // Only listen for touches within `rect`, in screen pixels, e.g. the client
+    // area of a window. Applies to integrated devices, such as a Cintiq, opaque
+    // tablets report the whole of their surface regardless.
+    //
+    // Cheap to call every frame, neither the lock is taken nor the SDK told
+    // unless the rect changes. Call from one thread, e.g. the one drawing.
+    void setHitRect(WacomMTHitRect rect);
+
+    // Capabilities of every attached device, as of when it was attached
+    auto devices() const -> std::vector<WacomMTCapability>;
+
+    // Most contacts there can be at once, across all attached devices
+    auto fingerMax() const -> std::size_t { return _fingerMax.load(std::memory_order_relaxed); }
 
 private:
-    PollEvents _events;
+    struct Device {
+        int deviceId { 0 };
+        bool used { false };
+
+        // Attached, as opposed to e.g. replayed
+        bool attached { false };
+        bool registered { false };
+        bool blobsRegistered { false };
+        bool rawRegistered { false };
+
+        // Registered with `hitRect`, rather than the whole device
+        bool clipped { false };
+        WacomMTHitRect hitRect {};
+
+        // Queried once, on attach
+        WacomMTCapability capability {};
+
+        JitterEstimator jitter;
+
+        // Of the last finger packet, for spotting gaps
+        int lastFrame { 0 };
+        bool seenFrame { false };
+
+        // In contact, according to packets seen so far
+        std::vector<FingerId> fingers;
+    };
+
+    // Serialises device bookkeeping and pushes to the queue of every producer,
+    // e.g. SDK threads and attach/detach, such that the queue only ever sees one
+    // at a time, in timestamp order. Never held for copying frames or for
+    // calling virtual callbacks.
+    mutable std::mutex _mutex;
+    std::array<Device, MAX_ATTACHED_DEVICES> _devices;
+    std::atomic<Device*> _lastDevice { nullptr };
+
+    // Written by the Wacom callback thread, read by `poll()`
+    RingBuffer<TouchEvent> _queue;
+    TripleBuffer<BlobFrame> _blobs;
+    TripleBuffer<RawFrame> _raw;
+    std::atomic<Recorder*> _recorder { nullptr };
+
+    // Held whilst filling the back buffer of either, frames arriving
+    // meanwhile from another device are dropped rather than waited on
+    std::atomic<bool> _blobsBusy { false };
+    std::atomic<bool> _rawBusy { false };
+    std::atomic<std::size_t> _rawContended { 0 };
+
+    // Until set, by the end of `init()`, nothing reads blob or raw frames
+    std::atomic<bool> _started { false };
+    std::atomic<bool> _blobsEnabled { false };
+    std::atomic<bool> _rawEnabled { false };
+    std::atomic<std::size_t> _fingerMax { DEFAULT_FINGER_MAX };
+
+    // Guarded by `_mutex`
+    WacomMTHitRect _hitRect {};
+    bool _hasHitRect { false };
+
+    // As last passed to `setHitRect()`, only touched by its caller
+    WacomMTHitRect _requestedHitRect {};
+    bool _hasRequestedHitRect { false };
+
+    // Written by `poll()`, readable from anywhere
+    std::atomic<Timestamp> _latencySum { 0 };
+    std::atomic<std::size_t> _latencyCount { 0 };
+    std::atomic<Timestamp> _latencyMax { 0 };
+    std::atomic<std::size_t> _coalesced { 0 };
+
+    Histogram _pollLatency;
+    Histogram _drawLatency;
+    Histogram _touchDownLatency;
+    Histogram _touchDuration;
+
+    // See `Integrity`, written by either side
+    std::atomic<std::size_t> _frameGaps { 0 };
+    std::atomic<std::size_t> _framesMissed { 0 };
+    std::atomic<std::size_t> _holdsWithoutDown { 0 };
+    std::atomic<std::size_t> _upsWithoutDown { 0 };
+    std::atomic<std::size_t> _unliftedFingers { 0 };
+    std::atomic<std::size_t> _downsLost { 0 };
+    std::atomic<std::size_t> _upsLost { 0 };
+
+    // Only ever touched by the thread calling `poll()`
+    Contacts _events;
+    Samples _samples;
+    float _coalesceEpsilon { DEFAULT_COALESCE_EPSILON };
+    Timestamp _coalesceMaxIdle { DEFAULT_COALESCE_MAX_IDLE };
+
+    // Of the last `poll()`, and of Downs it saw that are yet to be `drawn()`
+    Timestamp _polled { 0 };
+    std::vector<Timestamp> _undrawn;
+
+    // When each finger in contact went Down, for `touchDuration()`
+    struct Down {
+        int deviceId;
+        FingerId fingerId;
+        Timestamp timestamp;
+    };
+
+    std::vector<Down> _downs;
+
+    // Call with `_mutex` held
+    auto _device(int deviceId) -> Device*;
+    void _updateFingerMax();
+
+    // Size every blob and raw buffer for `capability`, during `init()`
+    void _reserveFrames(const WacomMTCapability& capability, bool blobs, bool raw);
+
+    void _drain();
+    void _consume(const TouchEvent& event);
+    void _liftStale(Timestamp drained);
+    bool _redundant(const TouchEvent& event) const;
+    void _advance();
 
     void _touchDownEvent(TouchEvent event);
     void _touchUpEvent(TouchEvent event);
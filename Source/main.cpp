@@ -1,16 +1,23 @@
 // (Optional) Magnum prefers to have its imgui.h included first
 #include <Magnum/ImGuiIntegration/Context.hpp>
 
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 #include <Magnum/Math/Color.h>
 #include <Magnum/Math/Vector.h>
 #include <Magnum/Magnum.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/PixelFormat.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Renderer.h>
+#include <Magnum/GL/Texture.h>
+#include <Magnum/GL/TextureFormat.h>
 #include <Magnum/GL/Version.h>
 #include <Magnum/Platform/GlfwApplication.h>
+#include <Corrade/Utility/Arguments.h>
 #include <Corrade/Utility/Resource.h>
 
 #include <entt/entity/registry.hpp>
@@ -21,10 +28,75 @@ using namespace Math::Literals;
 
 #include "Theme.inl"
 #include "Wacom.h"
+#include "ContactTracker.h"
+#include "LoadGenerator.h"
+#include "OneEuroFilter.h"
+#include "Predictor.h"
+#include "RasterLayer.h"
+#include "RawKernels.h"
+#include "Resampler.h"
+#include "Replay.h"
+#include "Session.h"
+#include "StrokeCache.h"
+#include "StrokeTessellator.h"
+#include "Strokes.h"
 
 entt::registry Registry;
 
 
+// Shared by the application and runs that need no window
+static auto options() -> Utility::Arguments {
+    Utility::Arguments args;
+    args.addOption("replay").setHelp("replay", "replay a recorded session instead of the tablet", "FILE")
+        .addOption("record").setHelp("record", "record every finger packet to a file", "FILE")
+        .addOption("speed", "1").setHelp("speed", "replay speed, 0 for as fast as possible")
+        .addOption("generate").setHelp("generate", "generate synthetic input instead of the tablet", "circle|zigzag|pinch|walk")
+        .addOption("fingers", "10").setHelp("fingers", "generated fingers")
+        .addOption("rate", "1000").setHelp("rate", "generated packets per second")
+        .addOption("seed", "0").setHelp("seed", "generator random seed")
+        .addOption("churn", "0").setHelp("churn", "chance of a generated finger lifting, per packet")
+        .addBooleanOption("blobs").setHelp("blobs", "also listen for blob contours, on tablets that support them")
+        .addBooleanOption("raw").setHelp("raw", "also listen for raw sensor frames, on tablets that support them")
+        .addOption("duration", "0").setHelp("duration", "seconds to generate for, 0 for as long as the application runs")
+        .addBooleanOption("reuse-ids").setHelp("reuse-ids", "generated fingers touch down with the most recently lifted ID, such that one packet may list an ID twice")
+        .addBooleanOption("evaluate").setHelp("evaluate", "print the prediction error of each model over the --replay session")
+        .addOption("horizon", "16").setHelp("horizon", "how far ahead to predict, in milliseconds")
+        .addBooleanOption("benchmark-strokes").setHelp("benchmark-strokes", "time the stroke tessellator against ImGui's PathStroke, from 10^3 to 10^6 points, then exit")
+        .addBooleanOption("benchmark").setHelp("benchmark", "with --replay, deliver packets as fast as they are polled, with --generate for --duration or 10 seconds; print the throughput and exit")
+        .addBooleanOption("benchmark-kernels").setHelp("benchmark-kernels", "time each raw frame kernel, scalar and vectorised, against the Scribble sample's, then exit")
+        .addBooleanOption("benchmark-tracker").setHelp("benchmark-tracker", "time the raw frame contact tracker over synthetic frames, then exit")
+        .addBooleanOption("stress-ring").setHelp("stress-ring", "check the sample queue for loss and reordering under load, then exit")
+        .addSkippedPrefix("magnum", "engine-specific options");
+
+    return args;
+}
+
+
+static auto loadOptions(const Utility::Arguments& args) -> Wacom::LoadOptions {
+    const auto gesture = args.value("generate");
+
+    Wacom::LoadOptions options;
+    options.gesture = gesture == "zigzag" ? Wacom::Gesture::ZigZag
+                    : gesture == "pinch" ? Wacom::Gesture::Pinch
+                    : gesture == "walk" ? Wacom::Gesture::RandomWalk
+                    : Wacom::Gesture::Circle;
+    options.fingers = args.value<int>("fingers");
+    options.rate = args.value<float>("rate");
+    options.seed = args.value<unsigned int>("seed");
+    options.churn = args.value<float>("churn");
+    options.reuseIds = args.isSet("reuse-ids");
+    options.duration = args.value<float>("duration");
+    return options;
+}
+
+
+static void printReport(const Wacom::LoadGenerator::Report& report) {
+    Debug() << report.packets << "packets at" << report.packetsPerSecond << "packets/s,"
+            << report.drops << "samples dropped, latency mean" << report.meanLatency / 1.0e3
+            << "us max" << report.maxLatency / 1.0e3 << "us";
+}
+
+
 class Application : public Platform::Application {
 public:
     explicit Application(const Arguments& arguments);
@@ -33,6 +105,8 @@ public:
 
 private:
     auto dpiScaling() const -> Vector2;
+    void updateHitRect();
+    bool drawRaster(ImDrawList& painter, std::size_t count, ImVec2 size);
     void viewportEvent(ViewportEvent& event) override;
 
     void keyPressEvent(KeyEvent& event) override;
@@ -46,23 +120,65 @@ private:
 
     ImGuiIntegration::Context _imgui{ NoCreate };
     Vector2                   _dpiScaling { 1.0f, 1.0f };
-    Wacom::Touch              _wacomTouch;
+
+    // Declared ahead of `_wacomTouch`, which refers to both
+    std::unique_ptr<Wacom::Reader>   _session;
+    std::unique_ptr<Wacom::Recorder> _recorder;
+
+    std::unique_ptr<Wacom::Touch> _wacomTouch;
+
+    // Also `_wacomTouch`, when generating input, for its report
+    Wacom::LoadGenerator*     _generator { nullptr };
+    bool                      _reported { false };
+    Wacom::Contacts           _contacts;
+
+    // Contacts found in raw frames, as an alternative to the SDK's
+    Wacom::ContactTracker     _tracker;
+    Wacom::Contacts           _rawContacts;
+
+    // Jitter removal, for MonitorMode
+    Wacom::OneEuroFilter      _filter;
+    bool                      _smoothing { true };
+
+    // Contacts as of one sensor frame ago, between samples
+    Wacom::Resampler          _resampler;
+    bool                      _resampling { true };
+
+    // Where fingers will be by the time a frame is seen
+    Wacom::Predictor          _predictor;
+    float                     _horizon { 16.0f };  // ms
 
     enum Mode {
         Draw = 0, Monitor
     };
 
+    enum Source {
+        SDK = 0, Raw
+    };
+
     int mode { Monitor };
+    int source { SDK };
 
-    struct Line {
-        std::vector<ImVec2> positions;
-        float radius { 1.0f };
-        ImColor color;
-        bool fill { false };
-    };
+    // Bounds of the Canvas window, as of the last frame
+    ImVec2 _canvasPos { 0.0f, 0.0f };
+    ImVec2 _canvasSize { 0.0f, 0.0f };
 
-    std::vector<Line> lines;
+    Wacom::Strokes strokes;
+    Wacom::StrokeCache _strokeCache;
     bool fill { false };
+
+    // Applied to each stroke once finished, in pixels
+    float _simplifyTolerance { DEFAULT_SIMPLIFY_TOLERANCE };
+
+    // Finished strokes, as one image rather than geometry
+    Wacom::RasterLayer _raster;
+    GL::Texture2D _rasterTexture { NoCreate };
+    Vector2i _rasterTextureSize { 0, 0 };
+    bool _rasterizing { true };
+
+    // Size the canvas is being resized to, and since when
+    Vector2i _rasterPending { 0, 0 };
+    Wacom::Timestamp _rasterPendingSince { 0 };
 };
 
 
@@ -127,14 +243,61 @@ Application::Application(const Arguments& arguments) : Platform::Application{
 
     this->setSwapInterval(1);  // VSync
 
-    if (_wacomTouch.init()) {
+    auto args = options();
+    args.parse(arguments.argc, arguments.argv);
+
+    if (!args.value("replay").empty()) {
+        _session = std::make_unique<Wacom::Reader>(args.value("replay"));
+
+        const auto speed = args.value<float>("speed");
+        const auto pacing = speed <= 0.0f ? Wacom::Pacing::AsFastAsPossible
+                          : speed == 1.0f ? Wacom::Pacing::RealTime
+                          : Wacom::Pacing::Accelerated;
+
+        _wacomTouch = std::make_unique<Wacom::Replay>(_session->fingers(), pacing, speed);
+
+        if (args.isSet("evaluate")) {
+            const char* names[] { "None", "Linear", "Quadratic", "Kalman" };
+            const auto horizon = Wacom::Timestamp(args.value<float>("horizon") * 1.0e6f);
+
+            for (int model = 0; model < 4; model++) {
+                Wacom::PredictionOptions options;
+                options.model = Wacom::PredictionModel(model);
+
+                const auto error = Wacom::evaluate(_session->fingers(), options, horizon);
+                Debug() << names[model] << "mean" << error.mean << "rms" << error.rms
+                        << "max" << error.max << "over" << error.count << "samples";
+            }
+        }
+    } else if (!args.value("generate").empty()) {
+        auto generator = std::make_unique<Wacom::LoadGenerator>(loadOptions(args));
+        _generator = generator.get();
+        _wacomTouch = std::move(generator);
+    } else {
+        _wacomTouch = std::make_unique<Wacom::Touch>();
+    }
+
+    _wacomTouch->setBlobsEnabled(args.isSet("blobs"));
+    _wacomTouch->setRawEnabled(args.isSet("raw"));
+
+    if (!args.value("record").empty()) {
+        _recorder = std::make_unique<Wacom::Recorder>(args.value("record"));
+        _wacomTouch->setRecorder(_recorder.get());
+    }
+
+    if (_wacomTouch->init()) {
         Debug() << "Successfully initialised the Wacom SDK.\n";
     } else {
         Debug() << "Couldn't initialise the Wacom SDK";
         abort();
     }
 
-    _wacomTouch.printAttachedDevices();
+    _wacomTouch->printAttachedDevices();
+
+    _horizon = args.value<float>("horizon");
+
+    // Polled into every frame, so allocate once up-front
+    _contacts = Wacom::Contacts{ _wacomTouch->fingerMax() };
 }
 
 
@@ -203,6 +366,88 @@ void Application::drawEvent() {
         ImGui::BeginChild("Options", ImVec2{ 300.0f, 400.0f }, false);
         {
             ImGui::SliderFloat("Fade Velocity", &speed, 0.0f, 1.0f, "", 3.0f);
+            ImGui::Text("Dropped: %d", int(_wacomTouch->droppedEvents()));
+            ImGui::Text("Coalesced: %d", int(_wacomTouch->coalescedEvents()));
+            if (_generator) {
+                const auto report = _generator->report();
+                ImGui::Text("Generated: %d packets, %.0f/s%s", int(report.packets), report.packetsPerSecond,
+                            _generator->finished() ? " (finished)" : "");
+
+                // Once, for the record
+                if (_generator->finished() && !_reported) {
+                    printReport(report);
+                    _reported = true;
+                }
+            }
+            if (_recorder) {
+                ImGui::Text("Recorded: %d fingers, %d packets dropped",
+                            int(_recorder->recordedCount()), int(_recorder->droppedCount()));
+            }
+
+            const auto integrity = _wacomTouch->integrity();
+            ImGui::Text("Frame Gaps: %d (%d frames)", int(integrity.frameGaps), int(integrity.framesMissed));
+            ImGui::Text("Hold without Down: %d", int(integrity.holdsWithoutDown));
+            ImGui::Text("Up without Down: %d", int(integrity.upsWithoutDown));
+            ImGui::Text("Never Lifted: %d", int(integrity.unliftedFingers));
+            ImGui::Text("Down lost in queue: %d", int(integrity.downsLost));
+            ImGui::Text("Up lost in queue: %d", int(integrity.upsLost));
+
+            float epsilon = _wacomTouch->coalesceEpsilon();
+            float idle = _wacomTouch->coalesceMaxIdle() / 1.0e6f;
+            bool coalescing { false };
+            coalescing |= ImGui::SliderFloat("Epsilon", &epsilon, 0.0f, 0.01f, "%.5f", 3.0f);
+            coalescing |= ImGui::SliderFloat("Max Idle (ms)", &idle, 0.0f, 1000.0f);
+            if (coalescing) _wacomTouch->setCoalescing(epsilon, Wacom::Timestamp(idle * 1.0e6f));
+            ImGui::Text("Frame Period: %.2f ms", _wacomTouch->framePeriod() / 1.0e6f);
+            ImGui::Text("Jitter: %.2f ms", _wacomTouch->jitter() / 1.0e6f);
+            ImGui::Text("Latency: %.2f ms (max %.2f ms)",
+                        _wacomTouch->meanLatency() / 1.0e6f,
+                        _wacomTouch->maxLatency() / 1.0e6f);
+
+            const auto& raw = _wacomTouch->rawFrame();
+            if (!raw.sensitivity.empty()) {
+                ImGui::Text("Raw: %dx%d, frame %d", raw.width, raw.height, raw.frameNumber);
+                ImGui::Text("Raw Skipped: %d", int(_wacomTouch->rawFramesSkipped()));
+            }
+
+            ImGui::Checkbox("Resample", &_resampling);
+            ImGui::SameLine();
+            ImGui::Text("Staleness: %.2f ms", _resampler.staleness() / 1.0e6f);
+
+            ImGui::Checkbox("Smoothing", &_smoothing);
+            if (_smoothing) {
+                auto options = _filter.options();
+                bool changed { false };
+                changed |= ImGui::SliderFloat("Min Cutoff", &options.position.minCutoff, 0.01f, 10.0f, "%.2f Hz", 2.0f);
+                changed |= ImGui::SliderFloat("Beta", &options.position.beta, 0.0f, 100.0f, "%.1f", 2.0f);
+                changed |= ImGui::SliderFloat("Size Cutoff", &options.size.minCutoff, 0.01f, 10.0f, "%.2f Hz", 2.0f);
+                changed |= ImGui::SliderFloat("Angle Cutoff", &options.orientation.minCutoff, 0.01f, 10.0f, "%.2f Hz", 2.0f);
+                if (changed) _filter.setOptions(options);
+            }
+
+            ImGui::RadioButton("SDK", &source, SDK);
+            ImGui::SameLine();
+            ImGui::RadioButton("Raw", &source, Raw);
+
+            if (source == Raw) {
+                bool baseline = _tracker.baselineEnabled();
+                if (ImGui::Checkbox("Baseline", &baseline)) _tracker.setBaselineEnabled(baseline);
+
+                if (baseline) {
+                    float sigmas = _tracker.baseline().sigmas();
+                    if (ImGui::SliderFloat("Sigmas", &sigmas, 1.0f, 10.0f)) {
+                        _tracker.baseline().setSigmas(sigmas);
+                    }
+                    if (ImGui::Button("Reset Baseline")) _tracker.baseline().reset();
+                }
+                else {
+                    int threshold = _tracker.threshold();
+                    if (ImGui::SliderInt("Threshold", &threshold, 0, 64)) {
+                        _tracker.setThreshold((unsigned short)threshold);
+                    }
+                }
+                ImGui::Text("Components: %d", int(_tracker.componentCount()));
+            }
         }
         ImGui::EndChild();
 
@@ -212,14 +457,36 @@ void Application::drawEvent() {
         static FingerEvents events;
         static FingerOpacities opacities;
 
-        for (const auto [id, finger] : _wacomTouch.poll()) {
+        // Keep draining the SDK either way, or its queue overflows
+        _wacomTouch->poll(_contacts);
+        _resampler.update(_wacomTouch->samples());
+
+        // Evenly spaced trails, regardless of how sensor and display frames line up
+        if (_resampling) {
+            _resampler.resample(_contacts, Wacom::now() - _wacomTouch->framePeriod());
+        }
+
+        if (source == Raw) {
+            _tracker.poll(_wacomTouch->rawFrame(), _rawContacts);
+        }
+
+        auto& contacts = source == Raw ? _rawContacts : _contacts;
+        if (_smoothing) _filter.apply(contacts);
+
+        for (const auto& finger : contacts) {
             if (!finger.confidence) continue;
 
             if (finger.state == Wacom::TouchState::Down) {
                 if (events.count(finger.fingerId)) events.erase(finger.fingerId);
             }
 
-            events[finger.fingerId].push_back(finger);
+            // Once per sensor frame, or resting fingers grow their trail forever;
+            // not by timestamp, which resampling moves along every frame
+            auto& trail = events[finger.fingerId];
+            if (trail.empty() || trail.back().frameNumber != finger.frameNumber || trail.back().state != finger.state) {
+                trail.push_back(finger);
+            }
+
             opacities[finger.fingerId] = 1.0f;
         }
 
@@ -239,6 +506,21 @@ void Application::drawEvent() {
             painter.AddText({ pos.x + 10.0f, pos.y - 10.0f }, col, std::to_string(finger.fingerId).c_str());
         }
 
+        // Blobs stop arriving once nothing touches, so skip stale frames
+        const auto& blobs = _wacomTouch->blobs();
+        if (Wacom::now() - blobs.timestamp < 100'000'000) {
+            for (const auto& blob : blobs.blobs) {
+                if (!blob.confidence) continue;
+
+                painter.PathClear();
+                for (const auto& point : blobs.contour(blob)) {
+                    painter.PathLineTo(ImVec2{ (point.X - blobs.originX) / blobs.width * size.x,
+                                               (point.Y - blobs.originY) / blobs.height * size.y });
+                }
+                painter.PathStroke(GetColor(blob.blobId, 0.5f), true);
+            }
+        }
+
         std::vector<int> erase;
         for (auto& [id, opacity] : opacities) {
             opacity -= opacity * speed;
@@ -259,16 +541,58 @@ void Application::drawEvent() {
         ImGui::BeginChild("Options", ImVec2{ 300.0f, 400.0f }, false);
         {
             ImGui::Checkbox("Fill", &fill);
+
+            auto options = _predictor.options();
+            int model = int(options.model);
+            if (ImGui::Combo("Prediction", &model, "None\0Linear\0Quadratic\0Kalman\0")) {
+                options.model = Wacom::PredictionModel(model);
+                _predictor.setOptions(options);
+            }
+            ImGui::SliderFloat("Horizon (ms)", &_horizon, 0.0f, 50.0f);
+
+            auto tessellation = _strokeCache.options();
+            int join = int(tessellation.join);
+            ImGui::Combo("Join", &join, "Miter\0Round\0");
+            ImGui::SliderFloat("Miter Limit", &tessellation.miterLimit, 1.0f, 10.0f);
+            tessellation.join = Wacom::StrokeJoin(join);
+            _strokeCache.setOptions(tessellation);
+
+            ImGui::SliderFloat("Simplify (px)", &_simplifyTolerance, 0.0f, 5.0f);
+            if (strokes.rawPointCount()) {
+                ImGui::Text("Points: %d of %d (%.0f%%)", int(strokes.pointCount()), int(strokes.rawPointCount()),
+                            100.0f * strokes.pointCount() / strokes.rawPointCount());
+            }
+
+            ImGui::Checkbox("Raster", &_rasterizing);
+            if (_rasterizing) {
+                ImGui::Text("Rasterized: %d strokes", int(_raster.strokeCount()));
+            }
+
+            ImGui::Text("Cached: %d vertices, %d pieces", int(_strokeCache.vertexCount()), int(_strokeCache.pieceCount()));
+            if (_strokeCache.skippedCount()) {
+                ImGui::Text("Skipped: %d pieces", int(_strokeCache.skippedCount()));
+            }
         }
         ImGui::EndChild();
 
-        auto fingers = _wacomTouch.poll();
+        _wacomTouch->poll(_contacts);
+        _predictor.update(_wacomTouch->samples());
+        _resampler.update(_wacomTouch->samples());
+        const auto& fingers = _contacts;
+        const auto displayed = Wacom::now() + Wacom::Timestamp(_horizon * 1.0e6f);
+        const auto resampled = Wacom::now() - _wacomTouch->framePeriod();
         static bool drawingInProgress { false };
+        const bool wasDrawing = drawingInProgress;
         std::string status { "" };
         auto& painter = *ImGui::GetForegroundDrawList();
 
         if (fingers.count(0)) {
-            auto finger = fingers.at(0);
+            // Ahead of the latest sample, or else a frame behind it but steady
+            auto finger = _predictor.predict(fingers.at(0), displayed);
+            if (_predictor.options().model == Wacom::PredictionModel::None && _resampling) {
+                finger = _resampler.resample(fingers.at(0), resampled);
+            }
+
             const auto radius = (finger.width + finger.height) * 50.0f;
             const auto col = GetColor(finger.fingerId);
             const auto pos = ImVec2{ finger.x * size.x, finger.y * size.y };
@@ -282,7 +606,7 @@ void Application::drawEvent() {
                 if (!drawingInProgress) {
                     auto finger = fingers.at(0);
                     const auto radius = (finger.width + finger.height) * 10.0f;
-                    lines.push_back({ {}, radius, GetColor(lines.size()), fill });
+                    strokes.begin(radius, GetColor(int(strokes.size())), fill);
                 }
 
                 drawingInProgress = true;
@@ -296,11 +620,29 @@ void Application::drawEvent() {
             }
         }
 
-        if (drawingInProgress) {
-            auto finger = fingers.at(0);
-            const auto pos = ImVec2{ finger.x * size.x, finger.y * size.y };
-            auto& line = lines.back();
-            line.positions.push_back(pos);
+        // Full fidelity whilst drawing, fewer points once finished
+        if (wasDrawing && !drawingInProgress) {
+            strokes.simplify(_simplifyTolerance);
+        }
+
+        // Include every sample since the last frame, not just the latest one
+        const auto* drawn = fingers.find(0);
+        if (drawingInProgress && !strokes.empty() && drawn) {
+            const std::size_t live = strokes.size() - 1;
+
+            // Of the finger being drawn with, rather than any other device's finger 0
+            for (const auto& sample : _wacomTouch->samples()) {
+                if (sample.fingerId != drawn->fingerId || sample.deviceId != drawn->deviceId ||
+                    sample.state == Wacom::TouchState::Up) continue;
+                strokes.append(ImVec2{ sample.x * size.x, sample.y * size.y },
+                               (sample.width + sample.height) * 10.0f);
+            }
+
+            // Nothing sampled this frame, e.g. it only just began, as finger 1 went down
+            if (strokes.points(live).empty()) {
+                strokes.append(ImVec2{ drawn->x * size.x, drawn->y * size.y },
+                               (drawn->width + drawn->height) * 10.0f);
+            }
         }
 
         ImFont* font = ImGui::GetIO().Fonts->Fonts[1];
@@ -308,11 +650,25 @@ void Application::drawEvent() {
         const ImVec2 center = { ImGui::GetWindowWidth() * 0.5f, ImGui::GetWindowHeight() * 0.5f };
         painter.AddText(font, 24.0f, center, ImColor::HSV(0.0f, 0.0f, 1.0f), status.c_str());
 
-        for (auto line : lines) {
-            painter.PathClear();
-            for (auto pos : line.positions) painter.PathLineTo(ImVec2{ pos.x, pos.y });
-            if (line.fill) painter.PathFillConvex(line.color);
-            else           painter.PathStroke(line.color, false, line.radius);
+        // Drawn once into an image, with only the live stroke left as geometry
+        std::size_t first { 0 };
+        if (_rasterizing) {
+            first = drawingInProgress && !strokes.empty() ? strokes.size() - 1 : strokes.size();
+
+            // Until the canvas settles on a size, as geometry
+            if (!this->drawRaster(painter, first, size)) first = 0;
+        }
+
+        // Tessellated once, and only the new part of the live stroke from then on
+        _strokeCache.update(strokes, drawingInProgress, painter);
+        _strokeCache.draw(painter, first);
+
+        // Ahead of the samples, but not part of the stroke itself
+        const std::size_t live = strokes.size() - 1;
+        if (drawingInProgress && !strokes.empty() && fingers.count(0) && !strokes.fill(live)) {
+            const auto finger = _predictor.predict(fingers.at(0), displayed);
+            painter.AddLine(strokes.points(live).back(), ImVec2{ finger.x * size.x, finger.y * size.y },
+                            strokes.color(live), strokes.widths(live).back());
         }
     };
 
@@ -322,11 +678,49 @@ void Application::drawEvent() {
         if (ImGui::Checkbox("Draw Mode", &temp)) this->mode = mode == Monitor ? Draw : Monitor;
         if (this->mode == Monitor) MonitorMode();
         if (this->mode == Draw) DrawMode();
+
+        _canvasPos = ImGui::GetWindowPos();
+        _canvasSize = ImGui::GetWindowSize();
+    }
+    ImGui::End();
+
+    // Follows both the window and the Canvas within it, e.g. when docked elsewhere
+    updateHitRect();
+
+    ImGui::Begin("Latency", nullptr);
+    {
+        const std::pair<const char*, const Wacom::Histogram*> histograms[] {
+            { "Callback to Poll", &_wacomTouch->pollLatency() },
+            { "Poll to Draw",     &_wacomTouch->drawLatency() },
+            { "Down to Drawn",    &_wacomTouch->touchDownLatency() },
+            { "Touch Duration",   &_wacomTouch->touchDuration() },
+        };
+
+        ImGui::Columns(6, "latency");
+        for (auto heading : { "", "Count", "p50 (ms)", "p95 (ms)", "p99 (ms)", "Max (ms)" }) {
+            ImGui::Text("%s", heading);
+            ImGui::NextColumn();
+        }
+        ImGui::Separator();
+
+        for (auto [name, histogram] : histograms) {
+            const auto snapshot = histogram->snapshot();
+            ImGui::Text("%s", name); ImGui::NextColumn();
+            ImGui::Text("%d", int(snapshot.count)); ImGui::NextColumn();
+            ImGui::Text("%.2f", snapshot.percentile(0.50) / 1.0e6f); ImGui::NextColumn();
+            ImGui::Text("%.2f", snapshot.percentile(0.95) / 1.0e6f); ImGui::NextColumn();
+            ImGui::Text("%.2f", snapshot.percentile(0.99) / 1.0e6f); ImGui::NextColumn();
+            ImGui::Text("%.2f", snapshot.max / 1.0e6f); ImGui::NextColumn();
+        }
+        ImGui::Columns(1);
+
+        if (ImGui::Button("Reset")) _wacomTouch->resetHistograms();
     }
     ImGui::End();
 
     _imgui.drawFrame();
     swapBuffers();
+    _wacomTouch->drawn();
     redraw();
 }
 
@@ -336,6 +730,80 @@ void Application::viewportEvent(ViewportEvent& event) {
 
     _imgui.relayout(Vector2{ event.windowSize() } / dpiScaling(),
         event.windowSize(), event.framebufferSize());
+
+    // Fonts may have been rebuilt for a new scale, and strokes with them
+    _strokeCache.invalidate();
+
+    updateHitRect();
+}
+
+
+// Returns false whilst there is nothing to draw, e.g. during a resize
+bool Application::drawRaster(ImDrawList& painter, std::size_t count, ImVec2 size) {
+    // In framebuffer pixels, for strokes as sharp as their geometry
+    const auto scale = Vector2{ framebufferSize() } / (Vector2{ windowSize() } / dpiScaling());
+    const Vector2i target { Vector2{ size.x, size.y } * scale };
+
+    // Reallocating and redrawing every stroke, every frame of a resize, is
+    // slower than drawing them as geometry until it's done
+    if (target != _raster.size() || scale.x() != _raster.scale()) {
+        const auto now = Wacom::now();
+
+        if (target != _rasterPending) {
+            _rasterPending = target;
+            _rasterPendingSince = now;
+        }
+
+        if (now - _rasterPendingSince < Wacom::Timestamp(RASTER_RESIZE_DELAY) * 1'000'000) return false;
+        _raster.resize(target, scale.x());
+    }
+
+    if (_raster.size().product() == 0) return false;
+
+    if (_raster.size() != _rasterTextureSize) {
+        _rasterTexture = GL::Texture2D{};
+        _rasterTexture.setWrapping(GL::SamplerWrapping::ClampToEdge)
+                      .setMinificationFilter(GL::SamplerFilter::Linear)
+                      .setMagnificationFilter(GL::SamplerFilter::Linear)
+                      .setStorage(1, GL::TextureFormat::RGBA8, _raster.size());
+        _rasterTextureSize = _raster.size();
+    }
+
+    _raster.rasterize(strokes, count);
+
+    // Upload changed rows and columns alone, straight from the full image
+    const auto dirty = _raster.dirty();
+    if (dirty.size().product() > 0) {
+        const ImageView2D view {
+            PixelStorage{}.setRowLength(_raster.size().x())
+                          .setSkip({ dirty.min(), 0 }),
+            PixelFormat::RGBA8Unorm, dirty.size(), _raster.image().data()
+        };
+
+        _rasterTexture.setSubImage(0, dirty.min(), view);
+        _raster.clean();
+    }
+
+    // Rows are top-down, as are ImGui's texture coordinates
+    painter.AddImage(static_cast<ImTextureID>(&_rasterTexture), ImVec2{ 0.0f, 0.0f }, size);
+    return true;
+}
+
+
+void Application::updateHitRect() {
+    if (_canvasSize.x <= 0.0f || _canvasSize.y <= 0.0f) return;
+
+    // ImGui is in window coordinates scaled down by DPI, the SDK in screen pixels
+    int windowX { 0 }, windowY { 0 };
+    glfwGetWindowPos(this->window(), &windowX, &windowY);
+
+    WacomMTHitRect rect;
+    rect.originX = float(windowX) + _canvasPos.x * _dpiScaling.x();
+    rect.originY = float(windowY) + _canvasPos.y * _dpiScaling.y();
+    rect.width = _canvasSize.x * _dpiScaling.x();
+    rect.height = _canvasSize.y * _dpiScaling.y();
+
+    _wacomTouch->setHitRect(rect);
 }
 
 
@@ -343,7 +811,9 @@ void Application::keyPressEvent(KeyEvent& event) {
     if (event.key() == KeyEvent::Key::Esc)          this->exit();
     if (event.key() == KeyEvent::Key::F)            this->fill ^= true;
     if (event.key() == KeyEvent::Key::Space)        {
-        lines.clear();
+        strokes.clear();
+        _strokeCache.invalidate();
+        _raster.clear();
         this->mode = mode == Monitor ? Draw : Monitor;
     }
     if(_imgui.handleKeyPressEvent(event)) return;
@@ -382,4 +852,128 @@ void Application::textInputEvent(TextInputEvent& event) {
 }
 
 
-MAGNUM_APPLICATION_MAIN(Application)
\ No newline at end of file
+// Runs that need neither a window nor a tablet, returns their exit code,
+// or -1 to carry on with the application
+static auto headless(int argc, char** argv) -> int {
+    auto args = options();
+    args.parse(argc, argv);
+
+    if (args.isSet("stress-ring")) {
+        // 10 fingers at 1 kHz drained once per frame, then as fast as the producer can go
+        const struct {
+            const char* name;
+            std::size_t count;
+            double rate;
+            double period;
+        } runs[] {
+            { "1 kHz, 60 Hz poll",    10'000,     1000.0, 1.0 / 60.0 },
+            { "Unpaced, busy poll",   10'000'000, 0.0,    0.0 },
+            { "Unpaced, 60 Hz poll",  10'000'000, 0.0,    1.0 / 60.0 },
+        };
+
+        bool ok { true };
+        for (const auto& run : runs) {
+            const auto result = Wacom::stress(DEFAULT_QUEUE_CAPACITY, run.count, 10, run.rate, run.period);
+            Debug() << run.name << "pushed" << result.pushed << "popped" << result.popped
+                    << "overflowed" << result.overflows << "reordered" << result.reordered
+                    << "torn" << result.torn << "lost" << result.lost
+                    << "in" << result.seconds << "s," << (result.ok() ? "ok" : "FAILED");
+            ok &= result.ok();
+        }
+
+        return ok ? 0 : 1;
+    }
+
+    if (args.isSet("benchmark-strokes")) {
+        // Neither window nor ImGui context, so shared data of our own
+        ImDrawListSharedData shared;
+        shared.CurveTessellationTol = 1.25f;
+
+        for (std::size_t points = 1000; points <= 1000000; points *= 10) {
+            const auto result = Wacom::benchmark(points, &shared, Wacom::TessellationOptions{});
+            Debug() << result.points << "points, PathStroke" << result.pathStroke << "ms over"
+                    << result.pathStrokeVertices << "vertices, StrokeTessellator" << result.tessellator
+                    << "ms over" << result.tessellatorVertices << "vertices";
+        }
+
+        return 0;
+    }
+
+    if (args.isSet("benchmark-kernels")) {
+        // Roughly the sensor of a 24" display tablet, and a large contour
+        const auto timings = Wacom::benchmarkKernels(160, 90, 1024, 2000);
+
+        Debug() << "Kernels built with" << Wacom::kernelPath() << Debug::nospace << ", in us per call";
+        for (const auto& timing : timings) {
+            Debug() << timing.name << "Scribble" << timing.scribble << "Scalar" << timing.scalar
+                    << Wacom::kernelPath() << timing.vectorised;
+        }
+
+        return 0;
+    }
+
+    if (args.isSet("benchmark-tracker")) {
+        for (const bool baseline : { false, true }) {
+            const auto result = Wacom::benchmarkTracker(160, 90, 10, 10000, baseline);
+            Debug() << result.width << Debug::nospace << "x" << Debug::nospace << result.height
+                    << (baseline ? "with baseline," : "with threshold,") << result.frames << "frames,"
+                    << float(result.contacts) / result.frames << "contacts per frame, mean"
+                    << result.meanFrame << "us, max" << result.maxFrame << "us";
+        }
+
+        return 0;
+    }
+
+    if (!args.value("replay").empty() && args.isSet("benchmark")) {
+        Wacom::Reader session { args.value("replay") };
+        if (!session.isOpen()) return 1;
+
+        Wacom::Replay replay { session.fingers(), Wacom::Pacing::AsFastAsPossible };
+        Wacom::Contacts contacts { replay.fingerMax() };
+        replay.init();
+
+        // In a tight loop, rather than once per frame
+        std::size_t samples { 0 };
+        while (!replay.finished()) {
+            replay.poll(contacts);
+            samples += replay.samples().size();
+        }
+
+        replay.wait();
+        replay.poll(contacts);
+        samples += replay.samples().size();
+
+        Debug() << replay.packetCount() << "packets," << samples << "samples at"
+                << replay.packetsPerSecond() << "packets/s," << replay.droppedEvents() << "dropped,"
+                << "mean latency" << replay.meanLatency() / 1.0e3 << "us";
+        return 0;
+    }
+
+    if (!args.value("generate").empty() && args.isSet("benchmark")) {
+        auto options = loadOptions(args);
+        if (options.duration <= 0.0f) options.duration = 10.0f;
+
+        Wacom::LoadGenerator generator { options };
+        Wacom::Contacts contacts { generator.fingerMax() };
+        generator.init();
+
+        while (!generator.finished()) generator.poll(contacts);
+
+        generator.wait();
+        generator.poll(contacts);
+
+        printReport(generator.report());
+        return 0;
+    }
+
+    return -1;
+}
+
+
+int main(int argc, char** argv) {
+    const int status = headless(argc, argv);
+    if (status >= 0) return status;
+
+    Application app({ argc, argv });
+    return app.exec();
+}
\ No newline at end of file